@@ -0,0 +1,138 @@
+
+#pragma once
+// counts the heap allocations (and their bytes) of every frame phase : built with ASTEROID_TRACK_ALLOCS
+// defined (before the first include of this file, the game and the benchmark are one .cpp each), the
+// global operator new counts every allocation into the phase its thread runs right now (ProfileScope
+// tells it), and the Profiler turns the counts into allocations per frame, otherwise it does nothing
+// - a steady frame should allocate nothing : all the stores and buffers are reserved before the game
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#if defined(ASTEROID_TRACK_ALLOCS) && defined(_WIN32)
+    #include <malloc.h> // _aligned_malloc
+#endif
+
+
+namespace Asteroid {
+
+    struct AllocCount {
+        std::uint64_t allocations = 0, bytes = 0;
+    };
+
+
+    ////////////////////////////////// @c ALLOC-TRACKER-CLASS //////////////////////////////////
+
+
+    class AllocTracker {
+
+        public :
+
+        #ifdef ASTEROID_TRACK_ALLOCS
+        static constexpr bool ENABLED = true;
+        #else
+        static constexpr bool ENABLED = false;
+        #endif
+        static constexpr short int SLOTS = 16;          // one per profiled phase
+        static constexpr short int OUTSIDE = SLOTS - 1; // the allocations outside any phase
+
+        private :
+
+        inline static std::array<std::atomic<std::uint64_t>, SLOTS> allocations{}, bytes{};
+        inline static thread_local short int slot = OUTSIDE;
+
+        public :
+
+        // the calling thread runs that phase now (until the phase it was in before is entered again)
+        static inline void enter(short int phase){ if (ENABLED){ slot = phase; } }
+        static inline short int current(){ return (ENABLED)? slot : OUTSIDE; }
+
+        // called by operator new (relaxed : only the totals matter, not their order)
+        static inline void count(std::size_t size){
+            allocations[slot].fetch_add(1, std::memory_order_relaxed);
+            bytes[slot].fetch_add(size, std::memory_order_relaxed);
+        }
+
+        // all the allocations of a phase so far (the Profiler takes the difference over a frame)
+        static AllocCount total(short int phase){
+            AllocCount c;
+            c.allocations = allocations[phase].load(std::memory_order_relaxed);
+            c.bytes = bytes[phase].load(std::memory_order_relaxed);
+            return c;
+        }
+    };
+}
+
+
+#ifdef ASTEROID_TRACK_ALLOCS
+
+namespace Asteroid {
+    // the over-aligned allocations (alignas bigger than what malloc gives) need their own malloc and free
+    inline void* alignedMalloc(std::size_t size, std::size_t alignment){
+    #if defined(_WIN32)
+        return _aligned_malloc((size == 0)? 1 : size, alignment);
+    #else
+        void *memory = nullptr;
+        return (posix_memalign(&memory, std::max(alignment, sizeof(void *)), (size == 0)? 1 : size) == 0)? memory : nullptr;
+    #endif
+    }
+    inline void alignedFree(void *memory){
+    #if defined(_WIN32)
+        _aligned_free(memory);
+    #else
+        std::free(memory);
+    #endif
+    }
+}
+
+// the replaced global allocation functions : every form of them (the array, sized, over-aligned and
+// nothrow ones) is counted, so no allocation of a frame is missed
+void* operator new(std::size_t size){
+    Asteroid::AllocTracker::count(size);
+    if (void *memory = std::malloc((size == 0)? 1 : size)){ return memory; }
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size){ return operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    Asteroid::AllocTracker::count(size);
+    return std::malloc((size == 0)? 1 : size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t &tag) noexcept { return operator new(size, tag); }
+void* operator new(std::size_t size, std::align_val_t alignment){
+    Asteroid::AllocTracker::count(size);
+    if (void *memory = Asteroid::alignedMalloc(size, static_cast<std::size_t>(alignment))){ return memory; }
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t alignment){ return operator new(size, alignment); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    Asteroid::AllocTracker::count(size);
+    return Asteroid::alignedMalloc(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &tag) noexcept {
+    return operator new(size, alignment, tag);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete" // (they are the malloc of operator new above)
+#endif
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, const std::nothrow_t &) noexcept { std::free(memory); }
+void operator delete[](void *memory, const std::nothrow_t &) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept { Asteroid::alignedFree(memory); }
+void operator delete[](void *memory, std::align_val_t) noexcept { Asteroid::alignedFree(memory); }
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept { Asteroid::alignedFree(memory); }
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept { Asteroid::alignedFree(memory); }
+void operator delete(void *memory, std::align_val_t, const std::nothrow_t &) noexcept { Asteroid::alignedFree(memory); }
+void operator delete[](void *memory, std::align_val_t, const std::nothrow_t &) noexcept { Asteroid::alignedFree(memory); }
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+#endif
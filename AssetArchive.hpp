@@ -0,0 +1,153 @@
+
+#pragma once
+// a single packed file holding all the images and sounds, read through a memory mapping
+// layout : "ASTPAK01", entry count (u32), then for every entry : name length (u16), name,
+//          offset (u64) and size (u64) of its bytes from the start of the file, then the data
+//          (numbers in the byte order of the machine which packed it)
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+namespace Asteroid {
+
+    constexpr char ARCHIVE_MAGIC[8] = { 'A', 'S', 'T', 'P', 'A', 'K', '0', '1' };
+
+    class AssetArchive {
+
+        private :
+
+        struct Entry { std::uint64_t offset, size; };
+
+        const unsigned char *data;
+        std::size_t dataSize;
+        std::map<std::string, Entry> entries;
+    #if defined(_WIN32)
+        HANDLE file, mapping;
+    #endif
+
+        void unmap(){
+            if (data == nullptr){ return; }
+        #if defined(_WIN32)
+            UnmapViewOfFile(data);  CloseHandle(mapping);  CloseHandle(file);
+        #else
+            munmap(const_cast<unsigned char*>(data), dataSize);
+        #endif
+            data = nullptr;  dataSize = 0;  entries.clear();
+        }
+
+        // read the table of contents, false if the file is not a (complete) archive
+        bool readEntries(){
+            std::size_t pos = sizeof(ARCHIVE_MAGIC);
+            std::uint32_t count;
+            if (dataSize < pos + sizeof(count)  or  std::memcmp(data, ARCHIVE_MAGIC, pos) != 0){ return false; }
+            std::memcpy(&count, data + pos, sizeof(count));  pos += sizeof(count);
+
+            for (std::uint32_t i = 0; i < count; ++i){
+                std::uint16_t nameLength;
+                Entry entry;
+                if (pos + sizeof(nameLength) > dataSize){ return false; }
+                std::memcpy(&nameLength, data + pos, sizeof(nameLength));  pos += sizeof(nameLength);
+                if (pos + nameLength + sizeof(entry.offset) + sizeof(entry.size) > dataSize){ return false; }
+
+                std::string name(reinterpret_cast<const char*>(data + pos), nameLength);  pos += nameLength;
+                std::memcpy(&entry.offset, data + pos, sizeof(entry.offset));  pos += sizeof(entry.offset);
+                std::memcpy(&entry.size, data + pos, sizeof(entry.size));      pos += sizeof(entry.size);
+                if (entry.offset + entry.size > dataSize){ return false; }
+                entries[name] = entry;
+            }
+            return true;
+        }
+
+        public :
+
+        AssetArchive() noexcept { data = nullptr;  dataSize = 0; }
+        ~AssetArchive(){ unmap(); }
+        AssetArchive(const AssetArchive &) = delete;
+        AssetArchive& operator=(const AssetArchive &) = delete;
+
+        // map the archive into memory, returns false (and stays closed) if it is missing or broken
+        bool open(const std::string &path){
+            unmap();
+        #if defined(_WIN32)
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE){ return false; }
+            LARGE_INTEGER fileSize;
+            mapping = (GetFileSizeEx(file, &fileSize))? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+            if (mapping == nullptr){ CloseHandle(file);  return false; }
+            data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (data == nullptr){ CloseHandle(mapping);  CloseHandle(file);  return false; }
+            dataSize = static_cast<std::size_t>(fileSize.QuadPart);
+        #else
+            int file = ::open(path.c_str(), O_RDONLY);
+            if (file < 0){ return false; }
+            struct stat fileInfo;
+            if (fstat(file, &fileInfo) != 0  or  fileInfo.st_size == 0){ ::close(file);  return false; }
+            void *mapped = mmap(nullptr, fileInfo.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            ::close(file); // the mapping stays valid after closing the file
+            if (mapped == MAP_FAILED){ return false; }
+            data = static_cast<const unsigned char*>(mapped);  dataSize = fileInfo.st_size;
+        #endif
+            if (not readEntries()){ unmap();  return false; }
+            return true;
+        }
+
+        inline bool isOpen() const { return data != nullptr; }
+
+        // find the bytes of a packed file (by the same path it was packed with)
+        bool find(const std::string &name, const void *&bytes, std::size_t &size) const {
+            auto found = entries.find(name);
+            if (found == entries.end()){ return false; }
+            bytes = data + found->second.offset;  size = found->second.size;
+            return true;
+        }
+
+        // pack the given files into one archive, returns false if a file could not be read or written
+        static bool pack(const std::string &archivePath, const std::vector<std::string> &files){
+            std::vector<std::vector<char>> contents;
+            for (const std::string &name : files){
+                std::ifstream in(name, std::ios::binary);
+                if (not in){ return false; }
+                contents.emplace_back((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            }
+            std::uint64_t offset = sizeof(ARCHIVE_MAGIC) + sizeof(std::uint32_t);
+            for (const std::string &name : files){ offset += sizeof(std::uint16_t) + name.size() + 2 * sizeof(std::uint64_t); }
+
+            std::ofstream out(archivePath, std::ios::binary | std::ios::trunc);
+            std::uint32_t count = files.size();
+            out.write(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            for (std::size_t i = 0; i < files.size(); ++i){
+                std::uint16_t nameLength = files[i].size();
+                std::uint64_t size = contents[i].size();
+                out.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+                out.write(files[i].data(), nameLength);
+                out.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+                out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+                offset += size;
+            }
+            for (const std::vector<char> &bytes : contents){ out.write(bytes.data(), bytes.size()); }
+            return static_cast<bool>(out);
+        }
+    };
+}
@@ -0,0 +1,193 @@
+
+#pragma once
+// loads the images and sounds on a thread pool (from the packed archive when there is one,
+// otherwise from the loose files), textures are then uploaded on the main thread which owns
+// the OpenGL context, and every asset remembers how long it took
+
+#include <SFML/Graphics.hpp>
+#include <SFML/Audio.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include "AssetArchive.hpp"
+#include "ThreadPool.hpp"
+
+
+namespace Asteroid {
+
+    enum AssetKind : short int { IMAGE_ASSET, TEXTURE_ASSET, SOUND_ASSET };
+    struct AssetFile {
+        const char *path;
+        AssetKind kind;
+        bool smooth;           // for textures
+        bool onDemand = false; // not loaded at the start, but on its first use (see TextureManager)
+    };
+
+
+    class AssetManager {
+
+        private :
+
+        using TimeClock = std::chrono::steady_clock;
+
+        struct Asset {
+            AssetKind kind;
+            bool smooth, uploaded, fromArchive;
+            std::atomic<bool> decoded;
+            sf::Image image;         // decoded pixels (images and textures)
+            sf::Texture texture;
+            sf::SoundBuffer sound;
+            double waitMs, decodeMs, uploadMs;
+            /*
+            decoded  : set by the worker when image / sound is ready
+            uploaded : set on the main thread when the texture is created from the image
+            waitMs   : time in the queue before a worker picked it up
+            */
+            Asset(AssetKind assetKind, bool smoothTexture) noexcept : decoded(false) {
+                kind = assetKind;  smooth = smoothTexture;  uploaded = fromArchive = false;
+                waitMs = decodeMs = uploadMs = 0.0;
+            }
+        };
+
+        ThreadPool &workers;
+        AssetArchive archive;
+        std::map<std::string, Asset> assets; // only changed on the main thread
+        std::mutex lock;
+        std::condition_variable decodedSignal;
+        TimeClock::time_point startTime;
+
+        static double msSince(TimeClock::time_point start){
+            return std::chrono::duration<double, std::milli>(TimeClock::now() - start).count();
+        }
+
+        // runs on a worker thread, only touches its own asset
+        void decode(const std::string &name, Asset &asset, TimeClock::time_point queuedAt){
+            auto start = TimeClock::now();
+            asset.waitMs = std::chrono::duration<double, std::milli>(start - queuedAt).count();
+
+            const void *bytes;  std::size_t size;
+            asset.fromArchive = archive.find(name, bytes, size);
+            if (asset.kind == SOUND_ASSET){
+                if (asset.fromArchive){ asset.sound.loadFromMemory(bytes, size); }
+                else { asset.sound.loadFromFile(name); }
+            }
+            else {
+                if (asset.fromArchive){ asset.image.loadFromMemory(bytes, size); }
+                else { asset.image.loadFromFile(name); }
+            }
+            asset.decodeMs = msSince(start);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                asset.decoded.store(true, std::memory_order_release);
+            }
+            decodedSignal.notify_all();
+        }
+
+        void request(const std::string &name, AssetKind kind, bool smooth){
+            auto placed = assets.emplace(std::piecewise_construct, std::forward_as_tuple(name),
+                                         std::forward_as_tuple(kind, smooth));
+            if (not placed.second){ return; } // already requested
+            Asset &asset = placed.first->second;
+            const std::string &key = placed.first->first;
+            auto queuedAt = TimeClock::now();
+            workers.submit([this, &key, &asset, queuedAt]{ decode(key, asset, queuedAt); });
+        }
+
+        void waitDecoded(Asset &asset){
+            if (asset.decoded.load(std::memory_order_acquire)){ return; }
+            std::unique_lock<std::mutex> guard(lock);
+            decodedSignal.wait(guard, [&asset]{ return asset.decoded.load(std::memory_order_acquire); });
+        }
+
+        // wait for the worker (if needed) and create the texture on this (main) thread
+        Asset& ready(const std::string &name){
+            Asset &asset = assets.at(name);
+            waitDecoded(asset);
+            if (asset.kind == TEXTURE_ASSET  and  not asset.uploaded){
+                auto start = TimeClock::now();
+                asset.texture.loadFromImage(asset.image);
+                asset.texture.setSmooth(asset.smooth);
+                asset.image = sf::Image(); // the pixels now live in the texture
+                asset.uploaded = true;  asset.uploadMs = msSince(start);
+            }
+            return asset;
+        }
+
+        public :
+
+        AssetManager(ThreadPool &pool, const std::string &archivePath) : workers(pool){
+            startTime = TimeClock::now();
+            archive.open(archivePath); // without an archive the loose files are read instead
+        }
+        ~AssetManager(){ workers.waitIdle(); } // the workers hold references to the assets
+
+        // queue the loading, assets are decoded in the order they are requested
+        void loadImage(const std::string &name){ request(name, IMAGE_ASSET, false); }
+        void loadTexture(const std::string &name, bool smooth = false){ request(name, TEXTURE_ASSET, smooth); }
+        void loadSound(const std::string &name){ request(name, SOUND_ASSET, false); }
+        void load(const AssetFile &file){ request(file.path, file.kind, file.smooth); }
+
+        // these block until the asset is loaded (it must have been requested before)
+        sf::Image& image(const std::string &name){ return ready(name).image; }
+        sf::Texture& texture(const std::string &name){ return ready(name).texture; }
+        sf::SoundBuffer& sound(const std::string &name){ return ready(name).sound; }
+
+        // upload the textures which are decoded by now (call it every frame while loading)
+        void update(){
+            for (auto &each : assets){
+                Asset &asset = each.second;
+                if (asset.kind == TEXTURE_ASSET  and  not asset.uploaded  and  asset.decoded.load(std::memory_order_acquire)){
+                    ready(each.first);
+                }
+            }
+        }
+        // free the pixels of an image asset which is not needed anymore (e.g. packed into an atlas)
+        void releaseImage(const std::string &name){ ready(name).image = sf::Image(); }
+        void finishAll(){ for (auto &each : assets){ ready(each.first); } }
+        // forget an asset (its pixels, texture or samples are freed), loading it again decodes it again
+        void unload(const std::string &name){
+            auto found = assets.find(name);
+            if (found == assets.end()){ return; }
+            waitDecoded(found->second); // a worker may still be writing it
+            assets.erase(found);
+        }
+
+        inline bool isRequested(const std::string &name) const { return assets.count(name) != 0; }
+        inline bool isDecoded(const std::string &name) const {
+            auto found = assets.find(name);
+            return found != assets.end()  and  found->second.decoded.load(std::memory_order_acquire);
+        }
+        // the decoded pixels still kept in the main memory (0 once they are uploaded or released)
+        std::size_t imageBytes(const std::string &name) const {
+            auto found = assets.find(name);
+            if (found == assets.end()  or  not found->second.decoded.load(std::memory_order_acquire)){ return 0; }
+            sf::Vector2u size = found->second.image.getSize();
+            return 4ULL * size.x * size.y;
+        }
+
+        inline bool usesArchive() const { return archive.isOpen(); }
+
+        // print how long every asset took (wait = time in the queue, decode = on a worker, upload = main thread),
+        // the ones a worker is still decoding (e.g. prefetched) are only listed : their times are not written yet
+        void printReport(){
+            short int pending = 0;
+            for (auto &each : assets){ pending += not each.second.decoded.load(std::memory_order_acquire); }
+            std::printf("assets loaded from %s with %u threads in %.1f ms (%d still pending)\n",
+                        (archive.isOpen())? "the archive" : "loose files", workers.size(), msSince(startTime), pending);
+            for (auto &each : assets){
+                const Asset &asset = each.second;
+                if (not asset.decoded.load(std::memory_order_acquire)){
+                    std::printf("  %-40s pending\n", each.first.c_str());
+                    continue;
+                }
+                std::printf("  %-40s wait %7.1f ms  decode %7.1f ms  upload %6.1f ms\n",
+                            each.first.c_str(), asset.waitMs, asset.decodeMs, asset.uploadMs);
+            }
+        }
+    };
+}
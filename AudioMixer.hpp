@@ -0,0 +1,155 @@
+
+#pragma once
+// plays the sound effects from a fixed pool of voices (preallocated sf::Sound's per buffer) : the
+// play requests of a frame are only queued, update() then hands them out once per frame, the most
+// important (and closest) first, and when all the voices of an effect are busy a request may take
+// over (steal) the least important one, so a burst of hits costs the same as a few of them
+
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+
+namespace Asteroid {
+
+    constexpr short int MAX_SOUND_REQUESTS = 64; // play requests kept per frame, the rest is dropped
+
+
+    class AudioMixer {
+
+        private :
+
+        struct Effect {
+            std::size_t firstVoice;
+            short int voiceCount, priority, granted;
+            bool retrigger, stopRequested;
+            /*
+            firstVoice : the voices of an effect are next to each other in "voices"
+            retrigger  : a new request may restart a busy voice of the same importance (otherwise it waits
+                         for a free voice, e.g. a continuous fire sound is not restarted on every bullet)
+            granted    : voices given to it in the current update()
+            */
+        };
+        struct Voice {
+            sf::Sound sound;
+            short int effect, priority;
+            float distance;
+            unsigned long startFrame;
+        };
+        struct Request {
+            short int effect, priority;
+            float distance;
+        };
+
+        std::vector<Effect> effects;
+        std::vector<Voice> voices;
+        std::array<Request, MAX_SOUND_REQUESTS> requests;
+        short int requestCount;
+        float listenerX, listenerY;
+        unsigned long frameNo, played, stolen, dropped;
+        /*
+        voices    : all made by addEffect() before the first sound plays, never added or removed later
+        requests  : the requests of the current frame, handed out by update()
+        listener  : where the player hears from (the distances are measured from it)
+        played    : requests which got a voice,  stolen : of those, the ones which stopped a busy voice
+        dropped   : requests which got no voice (all busy with more important sounds, or too many in a frame)
+        */
+
+        static bool moreImportant(const Request &a, const Request &b){
+            return (a.priority != b.priority)? a.priority > b.priority : a.distance < b.distance;
+        }
+
+        // a free voice of the effect, else the least important busy one (the farthest, then the oldest)
+        Voice& pickVoice(const Effect &effect){
+            Voice *victim = nullptr;
+            for (short int v = 0; v < effect.voiceCount; ++v){
+                Voice &voice = voices[effect.firstVoice + v];
+                if (voice.sound.getStatus() == sf::Sound::Stopped){ return voice; }
+                if (victim == nullptr  or  voice.priority < victim->priority
+                    or  (voice.priority == victim->priority  and  voice.distance > victim->distance)
+                    or  (voice.priority == victim->priority  and  voice.distance == victim->distance
+                         and  voice.startFrame < victim->startFrame)){
+                    victim = &voice;
+                }
+            }
+            return *victim;
+        }
+
+        public :
+
+        AudioMixer() noexcept {
+            requestCount = 0;  listenerX = listenerY = 0.0F;
+            frameNo = played = stolen = dropped = 0;
+        }
+        AudioMixer(const AudioMixer &) = delete;
+        AudioMixer& operator=(const AudioMixer &) = delete;
+
+        // a sound effect with its own "voiceCount" voices (how many of it can be heard at once),
+        // returns its id for play() and stop()
+        short int addEffect(const sf::SoundBuffer &buffer, short int voiceCount, short int priority,
+                            float pitch, float volume, bool retrigger){
+            effects.push_back({voices.size(), voiceCount, priority, 0, retrigger, false});
+            for (short int v = 0; v < voiceCount; ++v){
+                voices.push_back({sf::Sound(buffer), static_cast<short int>(effects.size() - 1), priority, 0.0F, 0});
+                voices.back().sound.setPitch(pitch);  voices.back().sound.setVolume(volume);
+            }
+            return static_cast<short int>(effects.size() - 1);
+        }
+
+        inline void setListener(float x, float y){ listenerX = x;  listenerY = y; }
+
+        // queue the effect, heard from (x, y), it starts on the next update()
+        // (a priority above the effect's own one lets it steal a voice from a less important sound)
+        void play(short int effect, float x, float y, short int priority = -1){
+            float distance = std::hypot(x - listenerX, y - listenerY);
+            if (priority < 0){ priority = effects[effect].priority; }
+            Request request = {effect, priority, distance};
+            if (requestCount < MAX_SOUND_REQUESTS){ requests[requestCount++] = request; }
+            else { // full : it replaces the least important (and farthest) request, if it is less important
+                Request &least = *std::max_element(requests.begin(), requests.end(), moreImportant);
+                if (moreImportant(request, least)){ least = request; }
+                ++dropped;
+            }
+            effects[effect].stopRequested = false;
+        }
+        // stop every voice of the effect on the next update()
+        void stop(short int effect){ effects[effect].stopRequested = true; }
+
+        // hand the queued requests out to the voices (call it once per frame)
+        void update(){
+            for (Effect &effect : effects){
+                effect.granted = 0;
+                if (not effect.stopRequested){ continue; }
+                for (short int v = 0; v < effect.voiceCount; ++v){ voices[effect.firstVoice + v].sound.stop(); }
+                effect.stopRequested = false;
+            }
+
+            // the most important and closest first, and only as many of an effect as it has voices
+            std::sort(requests.begin(), requests.begin() + requestCount, moreImportant);
+            for (short int r = 0; r < requestCount; ++r){
+                const Request &request = requests[r];
+                Effect &effect = effects[request.effect];
+                if (effect.granted == effect.voiceCount){ ++dropped;  continue; }
+
+                Voice &voice = pickVoice(effect);
+                bool busy = (voice.sound.getStatus() != sf::Sound::Stopped);
+                bool wins = voice.priority < request.priority  or  (voice.priority == request.priority  and  effect.retrigger);
+                if (busy  and  not wins){ ++dropped;  continue; }
+
+                if (busy){ voice.sound.stop();  ++stolen; }
+                voice.priority = request.priority;  voice.distance = request.distance;  voice.startFrame = frameNo;
+                voice.sound.play();
+                ++played;  ++effect.granted;
+            }
+            requestCount = 0;
+            ++frameNo;
+        }
+
+        inline std::size_t getVoiceCount() const { return voices.size(); }
+        inline unsigned long getPlayed() const { return played; }
+        inline unsigned long getStolen() const { return stolen; }
+        inline unsigned long getDropped() const { return dropped; }
+    };
+}
@@ -0,0 +1,207 @@
+
+#pragma once
+// batched update kernels: integrate and wrap every asteroid or bullet of a store in one go
+// with SSE (4 lanes) or AVX (8 lanes), the plain loops are kept as the scalar fallback
+// (define ASTEROID_NO_SIMD to force the scalar path, e.g. for comparing results)
+
+#include <cmath>
+#include <cstddef>
+
+#if !defined(ASTEROID_NO_SIMD) && defined(__AVX__)
+    #include <immintrin.h>
+    #define ASTEROID_SIMD_AVX
+#elif !defined(ASTEROID_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define ASTEROID_SIMD_SSE
+#endif
+
+
+namespace Asteroid {
+
+    constexpr auto DEG_TO_RAD = 0.017453F;
+
+
+    ////////////////////////////////// @c SCALAR-KERNELS //////////////////////////////////
+
+
+    // x += dx, y += dy and if an object moves off one side of the screen then it reappears on other side
+    inline void integrateWrapScalar(float *x, float *y, const float *dx, const float *dy,
+                                    std::size_t from, std::size_t to, float width, float height){
+        for (std::size_t i = from; i < to; ++i){
+            x[i] += dx[i];   y[i] += dy[i];
+            if (x[i] < 0.0F){ x[i] = width; }
+            if (y[i] < 0.0F){ y[i] = height; }
+            if (x[i] > width){ x[i] = 0.0F; }
+            if (y[i] > height){ y[i] = 0.0F; }
+        }
+    }
+
+    // bullets speed up (by thrust every step) towards their angle, and die (life = 0) when they go out of the screen,
+    // or with wrapEdges (large worlds) reappear on the other side like the asteroids
+    inline void integrateBulletsScalar(float *x, float *y, float *dx, float *dy, const float *angle, unsigned char *life,
+                                       std::size_t from, std::size_t to, float width, float height, float thrust,
+                                       bool wrapEdges = false){
+        for (std::size_t i = from; i < to; ++i){
+            dx[i] += std::cos(angle[i] * DEG_TO_RAD) * thrust; // calculate the velocity horizontal
+            dy[i] += std::sin(angle[i] * DEG_TO_RAD) * thrust; // calculate the velocity vertically
+            x[i] += dx[i];   y[i] += dy[i];                  // updae to the actual co-ordinates
+            if (wrapEdges){
+                if (x[i] < 0.0F){ x[i] = width; }
+                if (y[i] < 0.0F){ y[i] = height; }
+                if (x[i] > width){ x[i] = 0.0F; }
+                if (y[i] > height){ y[i] = 0.0F; }
+                continue;
+            }
+            if (x[i] < 0  or  x[i] > width){ life[i] = 0; }
+            if (y[i] < 0  or  y[i] > height){ life[i] = 0; }
+        }
+    }
+
+
+#if defined(ASTEROID_SIMD_AVX) || defined(ASTEROID_SIMD_SSE)
+
+    ////////////////////////////////// @c SIMD-LANES //////////////////////////////////
+
+
+    namespace Lanes { // the few vector operations the kernels need, for the chosen instruction set
+
+    #if defined(ASTEROID_SIMD_AVX)
+        using Float = __m256;
+        constexpr std::size_t COUNT = 8;
+        inline Float load(const float *p){ return _mm256_loadu_ps(p); }
+        inline void store(float *p, Float v){ _mm256_storeu_ps(p, v); }
+        inline Float set(float f){ return _mm256_set1_ps(f); }
+        inline Float add(Float a, Float b){ return _mm256_add_ps(a, b); }
+        inline Float sub(Float a, Float b){ return _mm256_sub_ps(a, b); }
+        inline Float mul(Float a, Float b){ return _mm256_mul_ps(a, b); }
+        inline Float bitAnd(Float a, Float b){ return _mm256_and_ps(a, b); }
+        inline Float bitAndNot(Float a, Float b){ return _mm256_andnot_ps(a, b); } // (not a) and b
+        inline Float bitOr(Float a, Float b){ return _mm256_or_ps(a, b); }
+        inline Float bitXor(Float a, Float b){ return _mm256_xor_ps(a, b); }
+        inline Float less(Float a, Float b){ return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        inline Float greater(Float a, Float b){ return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        inline Float equal(Float a, Float b){ return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+        inline Float truncate(Float a){ return _mm256_cvtepi32_ps(_mm256_cvttps_epi32(a)); }
+        inline int maskBits(Float m){ return _mm256_movemask_ps(m); }
+    #else
+        using Float = __m128;
+        constexpr std::size_t COUNT = 4;
+        inline Float load(const float *p){ return _mm_loadu_ps(p); }
+        inline void store(float *p, Float v){ _mm_storeu_ps(p, v); }
+        inline Float set(float f){ return _mm_set1_ps(f); }
+        inline Float add(Float a, Float b){ return _mm_add_ps(a, b); }
+        inline Float sub(Float a, Float b){ return _mm_sub_ps(a, b); }
+        inline Float mul(Float a, Float b){ return _mm_mul_ps(a, b); }
+        inline Float bitAnd(Float a, Float b){ return _mm_and_ps(a, b); }
+        inline Float bitAndNot(Float a, Float b){ return _mm_andnot_ps(a, b); } // (not a) and b
+        inline Float bitOr(Float a, Float b){ return _mm_or_ps(a, b); }
+        inline Float bitXor(Float a, Float b){ return _mm_xor_ps(a, b); }
+        inline Float less(Float a, Float b){ return _mm_cmplt_ps(a, b); }
+        inline Float greater(Float a, Float b){ return _mm_cmpgt_ps(a, b); }
+        inline Float equal(Float a, Float b){ return _mm_cmpeq_ps(a, b); }
+        inline Float truncate(Float a){ return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+        inline int maskBits(Float m){ return _mm_movemask_ps(m); }
+    #endif
+
+        // mask ? a : b  (without a branch)
+        inline Float select(Float mask, Float a, Float b){ return bitOr(bitAnd(mask, a), bitAndNot(mask, b)); }
+        // round down (for the positive values the kernels use)
+        inline Float floorPositive(Float a){
+            Float t = truncate(a);
+            return sub(t, bitAnd(greater(t, a), set(1.0F)));
+        }
+
+        // sin and cos of every lane (radians), the cephes single precision polynomials
+        // (good to about 1e-7 for the angles the game uses, |x| < 8192)
+        inline void sinCos(Float x, Float &sinX, Float &cosX){
+            const Float signBit = set(-0.0F);
+            Float sinSign = bitAnd(x, signBit);
+            x = bitAndNot(signBit, x); // |x|
+
+            // octant of the angle, rounded up to an even one (then x is reduced to [-pi/4, pi/4])
+            Float j = floorPositive(mul(x, set(1.27323954473516F))); // 4 / pi
+            j = mul(floorPositive(mul(add(j, set(1.0F)), set(0.5F))), set(2.0F));
+            x = sub(x, mul(j, set(0.78515625F)));
+            x = sub(x, mul(j, set(2.4187564849853515625e-4F)));
+            x = sub(x, mul(j, set(3.77489497744594108e-8F)));
+            Float octant = sub(j, mul(floorPositive(mul(j, set(0.125F))), set(8.0F))); // 0, 2, 4 or 6
+
+            Float z = mul(x, x);
+            Float cosPoly = add(mul(set(2.443315711809948e-5F), z), set(-1.388731625493765e-3F));
+            cosPoly = add(mul(cosPoly, z), set(4.166664568298827e-2F));
+            cosPoly = add(sub(mul(mul(cosPoly, z), z), mul(z, set(0.5F))), set(1.0F));
+            Float sinPoly = add(mul(set(-1.9515295891e-4F), z), set(8.3321608736e-3F));
+            sinPoly = add(mul(sinPoly, z), set(-1.6666654611e-1F));
+            sinPoly = add(mul(mul(sinPoly, z), x), x);
+
+            // octants 2 and 6 swap the polynomials, 4 and 6 flip the sin sign, 2 and 4 flip the cos sign
+            Float swap = bitOr(equal(octant, set(2.0F)), equal(octant, set(6.0F)));
+            Float sinFlip = greater(octant, set(3.0F));
+            Float cosFlip = bitOr(equal(octant, set(2.0F)), equal(octant, set(4.0F)));
+            sinX = bitXor(select(swap, cosPoly, sinPoly), bitXor(sinSign, bitAnd(sinFlip, signBit)));
+            cosX = bitXor(select(swap, sinPoly, cosPoly), bitAnd(cosFlip, signBit));
+        }
+
+        // the sequential wrap checks (x < 0 -> width, then x > width -> 0) as selects
+        inline Float wrap(Float x, Float size, Float zero){
+            x = select(less(x, zero), size, x);
+            return select(greater(x, size), zero, x);
+        }
+    }
+
+#endif
+
+
+    ////////////////////////////////// @c BATCH-KERNELS //////////////////////////////////
+
+
+    inline void integrateWrap(float *x, float *y, const float *dx, const float *dy,
+                              std::size_t count, float width, float height){
+        std::size_t i = 0;
+    #if defined(ASTEROID_SIMD_AVX) || defined(ASTEROID_SIMD_SSE)
+        using namespace Lanes;
+        const Float W = set(width), H = set(height), zero = set(0.0F);
+        for (; i + COUNT <= count; i += COUNT){
+            store(x + i, wrap(add(load(x + i), load(dx + i)), W, zero));
+            store(y + i, wrap(add(load(y + i), load(dy + i)), H, zero));
+        }
+    #endif
+        integrateWrapScalar(x, y, dx, dy, i, count, width, height); // the remaining objects
+    }
+
+    inline void integrateBullets(float *x, float *y, float *dx, float *dy, const float *angle, unsigned char *life,
+                                 std::size_t count, float width, float height, float thrust, bool wrapEdges = false){
+        std::size_t i = 0;
+    #if defined(ASTEROID_SIMD_AVX) || defined(ASTEROID_SIMD_SSE)
+        using namespace Lanes;
+        const Float W = set(width), H = set(height), zero = set(0.0F), toRadian = set(DEG_TO_RAD), T = set(thrust);
+        for (; i + COUNT <= count; i += COUNT){
+            Float sinA, cosA;
+            sinCos(mul(load(angle + i), toRadian), sinA, cosA);
+            Float vx = add(load(dx + i), mul(cosA, T)), vy = add(load(dy + i), mul(sinA, T));
+            Float px = add(load(x + i), vx),    py = add(load(y + i), vy);
+            if (wrapEdges){ px = wrap(px, W, zero);  py = wrap(py, H, zero); }
+            store(dx + i, vx);  store(dy + i, vy);  store(x + i, px);  store(y + i, py);
+            if (wrapEdges){ continue; }
+
+            Float out = bitOr(bitOr(less(px, zero), greater(px, W)), bitOr(less(py, zero), greater(py, H)));
+            int outBits = maskBits(out);
+            for (std::size_t lane = 0; outBits != 0; ++lane, outBits >>= 1){
+                if (outBits & 1){ life[i + lane] = 0; }
+            }
+        }
+    #endif
+        integrateBulletsScalar(x, y, dx, dy, angle, life, i, count, width, height, thrust, wrapEdges); // the remaining objects
+    }
+
+    // which instruction set the kernels were built with
+    inline const char* kernelLanes(){
+    #if defined(ASTEROID_SIMD_AVX)
+        return "AVX (8 lanes)";
+    #elif defined(ASTEROID_SIMD_SSE)
+        return "SSE2 (4 lanes)";
+    #else
+        return "scalar";
+    #endif
+    }
+}
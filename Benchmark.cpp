@@ -0,0 +1,714 @@
+
+// headless benchmarks for the simulation (no window, no audio device, no SFML)
+// build :  g++ -std=c++17 -O2 -pthread Benchmark.cpp -o Benchmark
+// "Benchmark --replay a.replay b.replay ..." only plays recorded games (see Replay.hpp) as fast as possible
+
+#define ASTEROID_TRACK_ALLOCS // count every heap allocation (AllocTracker.hpp), for the zero allocation check
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+#include "EffectSystem.hpp"
+#include "Random.hpp"
+#include "Replay.hpp"
+#include "SimThread.hpp"
+#include "Simulation.hpp"
+
+
+namespace Asteroid {
+
+    using BenchClock = std::chrono::steady_clock;
+
+    inline double secondsSince(BenchClock::time_point start){
+        return std::chrono::duration<double>(BenchClock::now() - start).count();
+    }
+
+
+    ////////////////////////////////// @c BROADPHASE-BENCHMARK //////////////////////////////////
+
+
+    // fill a store with randomly placed objects of the given radious
+    void scatter(EntityStore &store, std::size_t count, float width, float height, float radious, std::mt19937 &gen){
+        std::uniform_real_distribution<float> randX(0.0F, width), randY(0.0F, height);
+        store.clear();  store.reserve(count);
+        for (std::size_t i = 0; i < count; ++i){ store.add(BIG_ASTEROID_CLIP, randX(gen), randY(gen), 0, radious); }
+    }
+
+    // give every object of the store a random last move (dx, dy) of up to "speed" on each axis
+    void scatterMoves(EntityStore &store, float minSpeed, float maxSpeed, std::mt19937 &gen){
+        std::uniform_real_distribution<float> randSpeed(minSpeed, maxSpeed);
+        for (std::size_t i = 0; i < store.size(); ++i){ store.dx[i] = randSpeed(gen);  store.dy[i] = randSpeed(gen); }
+    }
+
+    // the collision pass without a broadphase (every bullet against every asteroid)
+    std::size_t bruteForceHits(const EntityStore &bullets, const EntityStore &asteroids, std::vector<std::uint64_t> &hits){
+        hits.clear();
+        for (std::size_t i = 0; i < bullets.size(); ++i){
+            for (std::size_t j = 0; j < asteroids.size(); ++j){
+                if (isSweptCollided(bullets, i, asteroids, j)){ hits.push_back(i << 32 | j); }
+            }
+        }
+        return bullets.size() * asteroids.size(); // pairs tested
+    }
+
+    // only where the bullets ended (the test before the swept one), to count the hits it misses
+    std::size_t endPointHits(const EntityStore &bullets, const EntityStore &asteroids){
+        std::size_t hits = 0;
+        for (std::size_t i = 0; i < bullets.size(); ++i){
+            for (std::size_t j = 0; j < asteroids.size(); ++j){ hits += isCollided(bullets, i, asteroids, j); }
+        }
+        return hits;
+    }
+
+    // the same pass through the spatial grid
+    std::size_t gridHits(const EntityStore &bullets, const EntityStore &asteroids, SpatialGrid &grid,
+                         std::vector<std::uint64_t> &hits){
+        std::size_t tested = 0;
+        hits.clear();
+        grid.build(asteroids);
+        for (std::size_t i = 0; i < bullets.size(); ++i){
+            std::size_t firstHit = hits.size();
+            float fromX = bullets.x[i] - bullets.dx[i], fromY = bullets.y[i] - bullets.dy[i];
+            grid.forEachNearBox(std::min(fromX, bullets.x[i]), std::min(fromY, bullets.y[i]),
+                                std::max(fromX, bullets.x[i]), std::max(fromY, bullets.y[i]), [&](std::uint64_t j){
+                ++tested;
+                if (isSweptCollided(bullets, i, asteroids, j)){ hits.push_back(i << 32 | j); }
+            });
+            std::sort(hits.begin() + firstHit, hits.end()); // a bullet's hits in asteroid order
+        }
+        return tested;
+    }
+
+    // returns false if the grid ever finds different hits than the full scan
+    bool broadphaseBenchmark(unsigned int seed){
+        const float width = 1280.0F, height = 800.0F; // the background size
+        const std::size_t bulletCount = 360;          // 3 seconds of continious fire
+        const short int repeats = 5;
+        bool same = true;
+
+        std::printf("\n--- broadphase : %zu bullets (moving up to 40 px a step) vs N asteroids in %.0fx%.0f ---\n",
+                    bulletCount, width, height);
+        std::printf("%10s %14s %14s %14s %14s %8s %10s %10s\n", "asteroids", "brute ms", "grid ms", "brute pairs",
+                    "grid pairs", "speedup", "hits", "end only");
+
+        for (std::size_t asteroidCount : {100, 1000, 2500, 5000, 10000, 20000}){
+            std::mt19937 gen(seed);
+            EntityStore bullets, asteroids;
+            scatter(bullets, bulletCount, width, height, 11, gen);
+            scatter(asteroids, asteroidCount, width, height, MAX_RADIOUS, gen);
+            scatterMoves(bullets, -40.0F, 40.0F, gen);  scatterMoves(asteroids, 0.0F, 2.0F, gen);
+
+            SpatialGrid grid;  grid.resize(width, height, 2 * MAX_RADIOUS);
+            std::vector<std::uint64_t> bruteList, gridList;
+            std::size_t brutePairs = 0, gridPairs = 0;
+
+            auto start = BenchClock::now();
+            for (short int r = 0; r < repeats; ++r){ brutePairs = bruteForceHits(bullets, asteroids, bruteList); }
+            double bruteMs = secondsSince(start) * 1000.0 / repeats;
+
+            start = BenchClock::now();
+            for (short int r = 0; r < repeats; ++r){ gridPairs = gridHits(bullets, asteroids, grid, gridList); }
+            double gridMs = secondsSince(start) * 1000.0 / repeats;
+
+            if (bruteList != gridList){ same = false; }
+            std::printf("%10zu %14.3f %14.3f %14zu %14zu %7.1fx %10zu %10zu%s\n", asteroidCount, bruteMs, gridMs,
+                        brutePairs, gridPairs, bruteMs / gridMs, bruteList.size(), endPointHits(bullets, asteroids),
+                        (bruteList == gridList)? "" : "  HITS DIFFER !");
+        }
+        return same;
+    }
+
+
+    ////////////////////////////////// @c UPDATE-KERNEL-BENCHMARK //////////////////////////////////
+
+
+    // times the batch kernels against their scalar loops, and checks they give the same results
+    bool kernelBenchmark(unsigned int seed){
+        const float width = 1280.0F, height = 800.0F, thrust = ARCHETYPES[SINGLE_BULLET_KIND].thrust;
+        const std::size_t count = 100000;
+        const short int repeats = 20;
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> randX(0.0F, width), randY(0.0F, height),
+                                              randSpeed(-30.0F, 30.0F), randAngle(-50000.0F, 50000.0F);
+
+        std::vector<float> x(count), y(count), dx(count), dy(count), angle(count);
+        for (std::size_t i = 0; i < count; ++i){
+            x[i] = randX(gen);  y[i] = randY(gen);  dx[i] = randSpeed(gen);  dy[i] = randSpeed(gen);  angle[i] = randAngle(gen);
+        }
+        std::printf("\n--- update kernels : %zu objects, %s ---\n", count, kernelLanes());
+
+        // ----- parity : one step of each kernel against the scalar loop -----
+        std::vector<float> sx = x, sy = y, sdx = dx, sdy = dy, kx = x, ky = y, kdx = dx, kdy = dy;
+        std::vector<unsigned char> sLife(count, 1), kLife(count, 1);
+        integrateWrapScalar(sx.data(), sy.data(), sdx.data(), sdy.data(), 0, count, width, height);
+        integrateWrap(kx.data(), ky.data(), kdx.data(), kdy.data(), count, width, height);
+        bool wrapSame = (sx == kx  and  sy == ky);
+
+        sx = x;  sy = y;  kx = x;  ky = y;
+        integrateBulletsScalar(sx.data(), sy.data(), sdx.data(), sdy.data(), angle.data(), sLife.data(), 0, count, width, height, thrust);
+        integrateBullets(kx.data(), ky.data(), kdx.data(), kdy.data(), angle.data(), kLife.data(), count, width, height, thrust);
+        float maxError = 0.0F;
+        std::size_t lifeDiffers = 0;
+        for (std::size_t i = 0; i < count; ++i){
+            maxError = std::max({maxError, std::abs(sx[i] - kx[i]), std::abs(sy[i] - ky[i]),
+                                 std::abs(sdx[i] - kdx[i]), std::abs(sdy[i] - kdy[i])});
+            // a bullet right on the screen edge may go either way within the float tolerance
+            bool onEdge = std::min({std::abs(sx[i]), std::abs(sx[i] - width), std::abs(sy[i]), std::abs(sy[i] - height)}) < 1e-3F;
+            if (sLife[i] != kLife[i]  and  not onEdge){ ++lifeDiffers; }
+        }
+        bool bulletsSame = (maxError < 1e-3F  and  lifeDiffers == 0);
+
+        // a large world wraps the bullets around its edges instead, and never ends one
+        std::vector<float> wx = x, wy = y, wdx = dx, wdy = dy, vx = x, vy = y, vdx = dx, vdy = dy;
+        std::vector<unsigned char> wLife(count, 1), vLife(count, 1);
+        integrateBulletsScalar(wx.data(), wy.data(), wdx.data(), wdy.data(), angle.data(), wLife.data(), 0, count, width, height, thrust, true);
+        integrateBullets(vx.data(), vy.data(), vdx.data(), vdy.data(), angle.data(), vLife.data(), count, width, height, thrust, true);
+        std::size_t wrapDiffers = 0;
+        for (std::size_t i = 0; i < count; ++i){
+            bool close = std::abs(wx[i] - vx[i]) < 1e-3F  and  std::abs(wy[i] - vy[i]) < 1e-3F;
+            bool onEdge = std::min({std::abs(wx[i]), std::abs(wx[i] - width), std::abs(wy[i]), std::abs(wy[i] - height)}) < 1e-3F;
+            if ((not close  and  not onEdge)  or  wLife[i] != 1  or  vLife[i] != 1){ ++wrapDiffers; }
+        }
+        bulletsSame = bulletsSame  and  wrapDiffers == 0;
+        std::printf("parity : wrap %s, bullets max error %.2e, life differs %zu, wrapped differ %zu -> %s\n",
+                    (wrapSame)? "exact" : "DIFFERS", maxError, lifeDiffers, wrapDiffers, (wrapSame and bulletsSame)? "ok" : "FAILED !");
+
+        // ----- speed -----
+        auto start = BenchClock::now();
+        for (short int r = 0; r < repeats; ++r){
+            integrateWrapScalar(sx.data(), sy.data(), dx.data(), dy.data(), 0, count, width, height);
+        }
+        double wrapScalarNs = secondsSince(start) * 1e9 / (repeats * count);
+        start = BenchClock::now();
+        for (short int r = 0; r < repeats; ++r){ integrateWrap(kx.data(), ky.data(), dx.data(), dy.data(), count, width, height); }
+        double wrapBatchNs = secondsSince(start) * 1e9 / (repeats * count);
+
+        start = BenchClock::now();
+        for (short int r = 0; r < repeats; ++r){
+            integrateBulletsScalar(sx.data(), sy.data(), sdx.data(), sdy.data(), angle.data(), sLife.data(), 0, count, width, height, thrust);
+        }
+        double bulletScalarNs = secondsSince(start) * 1e9 / (repeats * count);
+        start = BenchClock::now();
+        for (short int r = 0; r < repeats; ++r){
+            integrateBullets(kx.data(), ky.data(), kdx.data(), kdy.data(), angle.data(), kLife.data(), count, width, height, thrust);
+        }
+        double bulletBatchNs = secondsSince(start) * 1e9 / (repeats * count);
+
+        std::printf("%22s %12s %12s %8s\n", "kernel", "scalar ns", "batch ns", "speedup");
+        std::printf("%22s %12.3f %12.3f %7.1fx\n", "asteroid integrate+wrap", wrapScalarNs, wrapBatchNs, wrapScalarNs / wrapBatchNs);
+        std::printf("%22s %12.3f %12.3f %7.1fx\n", "bullet integrate", bulletScalarNs, bulletBatchNs, bulletScalarNs / bulletBatchNs);
+        return wrapSame and bulletsSame;
+    }
+
+
+    ////////////////////////////////// @c RANDOM-BENCHMARK //////////////////////////////////
+
+
+    // the old way (std::mt19937 through a 0 .. 1000 distribution, then a modulo) against Random,
+    // one number at a time and a whole buffer at once, and checks the streams are reproducible
+    bool randomBenchmark(unsigned int seed){
+        const std::size_t count = 1000000;
+        std::vector<float> out(count);
+        volatile float sink = 0.0F;
+
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<> randNo(0, 1000);
+        auto start = BenchClock::now();
+        for (std::size_t i = 0; i < count; ++i){ out[i] = randNo(gen) % 7 - 3; }
+        double mtNs = secondsSince(start) * 1e9 / count;
+        sink = sink + out[count / 2];
+
+        Random random(seed, WEAPON_STREAM);
+        start = BenchClock::now();
+        for (std::size_t i = 0; i < count; ++i){ out[i] = random.range(-3, 3); }
+        double oneNs = secondsSince(start) * 1e9 / count;
+        sink = sink + out[count / 2];
+
+        start = BenchClock::now();
+        random.fill(out.data(), count, -3, 3);
+        double fillNs = secondsSince(start) * 1e9 / count;
+        sink = sink + out[count / 2];
+
+        // the same seed and stream give the same numbers, another stream others, all in the range
+        Random a(seed, SPAWN_STREAM), b(seed, SPAWN_STREAM), c(seed, EFFECT_STREAM);
+        std::size_t differs = 0, sameAsOther = 0, outside = 0;
+        std::array<std::size_t, 7> histogram = {};
+        for (std::size_t i = 0; i < count; ++i){
+            std::uint32_t x = a.next();
+            if (x != b.next()){ ++differs; }
+            if (x == c.next()){ ++sameAsOther; }
+            int r = a.range(-3, 3);
+            if (r != b.range(-3, 3)){ ++differs; }
+            if (r < -3  or  r > 3){ ++outside; } else { ++histogram[r + 3]; }
+        }
+        auto extremes = std::minmax_element(histogram.begin(), histogram.end());
+        double skew = (*extremes.second - *extremes.first) / (count / 7.0); // 0 = perfectly even
+        bool ok = (differs == 0  and  sameAsOther < 4  and  outside == 0  and  skew < 0.02);
+
+        std::printf("\n--- random numbers : %zu spread values of -3 .. 3 ---\n", count);
+        std::printf("%22s %10.2f ns\n%22s %10.2f ns\n%22s %10.2f ns\n", "mt19937 + modulo", mtNs,
+                    "Random::range", oneNs, "Random::fill", fillNs);
+        std::printf("reproducible %s, streams apart %s, in range %s, bucket skew %.3f -> %s\n", (differs == 0)? "yes" : "NO",
+                    (sameAsOther < 4)? "yes" : "NO", (outside == 0)? "yes" : "NO", skew, (ok)? "ok" : "FAILED !");
+        return ok;
+    }
+
+
+    ////////////////////////////////// @c GAME-LOOP-SCENARIOS //////////////////////////////////
+
+
+    struct Scenario {
+        const char *name;
+        short int asteroids;       // big asteroids of the starting wave
+        short int fireType;        // special fire type held for the whole run (0 = no fire)
+        bool invulnerable;         // the ship survives any number of hits
+        int steps;
+    };
+
+    // plays scripted scenarios through the whole World::step and divides the time of its phases
+    // by the objects they worked on (ns per object per step), fails if one ends before all its steps
+    bool scenarioBenchmark(unsigned int seed){
+        const Scenario scenarios[] = {
+            {"wave 40",                 200, 0, true,  1200},
+            {"5000 big asteroids",     5000, 0, true,   600},
+            {"fire type 3 for 3 s",    1000, 3, true,   360},
+            {"explosion chains",       3000, 3, true,   600}
+        };
+        StoreLimits limits;
+        limits.bullets = 4096;  limits.asteroids = 16384;
+        bool ok = true;
+
+        std::printf("\n--- game loop scenarios : ns per object per step ---\n");
+        std::printf("%20s %6s %9s %9s %11s %11s %11s %9s\n", "scenario", "steps", "objects", "step us",
+                    "collision", "update", "spawn/new", "effects");
+        for (const Scenario &scenario : scenarios){
+            World world(1280, 800, seed, limits);
+            Profiler profiler;
+            world.setShipInvulnerable(scenario.invulnerable);
+            world.startWave(scenario.asteroids);
+            world.setProfiler(&profiler);
+
+            FrameInput input;
+            input.right = true;
+            input.specialFire = (scenario.fireType > 0);
+            input.fireTypeChanges = std::max(scenario.fireType - 1, 0); // the game starts with type 1
+            double objectSteps = 0.0;
+            std::size_t effects = 0; // explosions started (the front end plays them, the steps don't)
+            int steps = 0;
+            for (; steps < scenario.steps  and  not world.isGameOver(); ++steps){
+                objectSteps += world.getBullets().size() + world.getAsteroids().size();
+                profiler.beginFrame();
+                world.step(input);
+                profiler.endFrame();
+                effects += world.lastEffects().size();
+                input.fireTypeChanges = 0;
+            }
+            // every broken big asteroid scored a point and spawned 4 small ones
+            double spawned = 4.0 * world.getPlayerScore();
+            auto nsPerObject = [&](ProfilePhase phase){ return profiler.getTotalMs(phase) * 1e6 / objectSteps; };
+
+            std::printf("%20s %6d %9.0f %9.1f %11.2f %11.2f %11.2f %9zu\n", scenario.name, steps, objectSteps / steps,
+                        profiler.getTotalFrameMs() * 1e3 / steps, nsPerObject(COLLISION_PHASE), nsPerObject(UPDATE_PHASE),
+                        (spawned > 0.0)? profiler.getTotalMs(SPAWN_PHASE) * 1e6 / spawned : 0.0,
+                        effects);
+            if (steps < scenario.steps){
+                std::printf("%20s ended at step %d of %d -> FAILED !\n", scenario.name, steps, scenario.steps);
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+
+    ////////////////////////////////// @c EFFECTS-BENCHMARK //////////////////////////////////
+
+
+    // keeps thousands of explosions and trails alive (every finished one is replaced by a new one)
+    // and times EffectSystem::update, the only per effect work besides the drawing
+    void effectsBenchmark(unsigned int seed){
+        const std::size_t count = 20000;
+        const int frames = 600;
+        const float frameSeconds = 1.0F / 60.0F;
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> randX(0.0F, 1280.0F), randY(0.0F, 800.0F), randLife(0.05F, 0.5F);
+        std::uniform_int_distribution<int> randClip(EXPLOSION_CLIP_1, EXPLOSION_CLIP_3);
+
+        EffectSystem effects(2 * count); // (trails only take up to 3/4 of the capacity)
+        auto refill = [&](){
+            while (effects.size() < count){
+                if (effects.size() % 2 == 0){ effects.addExplosion({static_cast<short int>(randClip(gen)), randX(gen), randY(gen)}); }
+                else { effects.addTrail(BLUE_BULLET_CLIP, 0, randX(gen), randY(gen), 0.0F, randLife(gen), 96); }
+            }
+        };
+        double seconds = 0.0, updated = 0.0;
+        for (int f = 0; f < frames; ++f){
+            refill();
+            updated += effects.size();
+            auto start = BenchClock::now();
+            effects.update(frameSeconds);
+            seconds += secondsSince(start);
+        }
+        std::printf("\n--- effects : %zu alive, %d frames ---\n", count, frames);
+        std::printf("update %.2f ns per effect, peak %zu, capacity %zu, growths %u\n", seconds * 1e9 / updated,
+                    effects.getPeak(), effects.getCapacity(), effects.getGrowths());
+    }
+
+
+    ////////////////////////////////// @c PARALLEL-STEP-BENCHMARK //////////////////////////////////
+
+
+    // plays a huge wave under a bullet storm with and without worker threads, checks that every step
+    // ends in exactly the same state (also while the workers are busy decoding, as in the game : then the
+    // steps must not wait for the decodes), and times the steps for a few pool sizes
+    bool parallelBenchmark(unsigned int seed){
+        const short int asteroidCount = 12000;
+        const int steps = 300;
+        StoreLimits limits;
+        limits.bullets = 4096;  limits.asteroids = 65536;
+        FrameInput input;
+        input.right = true;  input.singleFires = 16;
+
+        auto play = [&](ThreadPool *pool, std::vector<std::uint64_t> *hashes, double *slowestMs = nullptr){
+            World world(1280, 800, seed, limits);
+            world.setShipInvulnerable(true);
+            world.setThreadPool(pool);
+            world.startWave(asteroidCount);
+            auto start = BenchClock::now();
+            for (int s = 0; s < steps; ++s){
+                auto stepStart = BenchClock::now();
+                world.step(input);
+                if (slowestMs != nullptr){ *slowestMs = std::max(*slowestMs, secondsSince(stepStart) * 1e3); }
+                if (hashes != nullptr){ hashes->push_back(world.stateHash()); }
+            }
+            return secondsSince(start) * 1e6 / steps;
+        };
+
+        std::printf("\n--- parallel step : %d big asteroids, 16 bullets per step, %u hardware threads ---\n",
+                    asteroidCount, std::thread::hardware_concurrency());
+        std::vector<std::uint64_t> serialHashes, parallelHashes;
+        play(nullptr, &serialHashes);
+        ThreadPool checkPool(4);
+        play(&checkPool, &parallelHashes);
+        std::size_t firstDiff = std::mismatch(serialHashes.begin(), serialHashes.end(), parallelHashes.begin()).first
+                                - serialHashes.begin();
+        bool same = (firstDiff == serialHashes.size());
+        std::printf("determinism : 4 workers vs serial over %d steps -> %s\n", steps,
+                    (same)? "same state every step" : "FAILED !");
+        if (not same){ std::printf("  first different state after step %zu\n", firstDiff + 1); }
+
+        // two long "decodes" queued on every worker before the game steps on the same pool
+        const double decodeMs = 200.0;
+        ThreadPool busyPool(4);
+        for (unsigned int d = 0; d < 2 * busyPool.size(); ++d){
+            busyPool.submit([decodeMs](){ std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(decodeMs)); });
+        }
+        std::vector<std::uint64_t> busyHashes;
+        double slowestMs = 0.0;
+        play(&busyPool, &busyHashes, &slowestMs);
+        busyPool.waitIdle();
+        bool busyOk = (busyHashes == serialHashes)  and  slowestMs < decodeMs / 2;
+        std::printf("busy pool : %u x %.0f ms decodes queued, slowest step %.1f ms, same state -> %s\n",
+                    2 * busyPool.size(), decodeMs, slowestMs, (busyOk)? "ok" : "FAILED !");
+        same = same  and  busyOk;
+
+        double serialUs = play(nullptr, nullptr);
+        std::printf("%10s %12s %8s\n", "workers", "step us", "speedup");
+        std::printf("%10s %12.1f %8s\n", "serial", serialUs, "-");
+        for (unsigned int workers : {1U, 2U, 4U, std::max(1U, std::thread::hardware_concurrency())}){
+            ThreadPool pool(workers);
+            double us = play(&pool, nullptr);
+            std::printf("%10u %12.1f %7.2fx\n", workers, us, serialUs / us);
+        }
+        return same;
+    }
+
+
+    ////////////////////////////////// @c REPLAY-RUNS //////////////////////////////////
+
+
+    // step a recorded game again, print the step time statistics and check it ends in the recorded state
+    bool replayRun(const std::string &path){
+        InputReplay replay;
+        if (not replay.open(path)){ std::printf("%s : not a replay file\n", path.c_str());  return false; }
+        StoreLimits limits;  limits.asteroids *= replay.getWaveScale();
+        World world(replay.getWidth(), replay.getHeight(), replay.getSeed(), limits);
+        world.setActiveRange(replay.getActiveRangeX(), replay.getActiveRangeY());
+        world.setWaveScale(replay.getWaveScale());
+        std::vector<double> stepUs;
+        FrameInput input;
+        while (replay.next(input)){
+            auto start = BenchClock::now();
+            world.step(input);
+            stepUs.push_back(secondsSince(start) * 1e6);
+        }
+        if (stepUs.empty()){ std::printf("%s : no steps\n", path.c_str());  return false; }
+
+        double total = 0.0;
+        for (double us : stepUs){ total += us; }
+        std::sort(stepUs.begin(), stepUs.end());
+        auto percentile = [&stepUs](double p){ return stepUs[static_cast<std::size_t>(p * (stepUs.size() - 1))]; };
+        bool same = (replay.hasEnd()  and  replay.getEndSteps() == stepUs.size()  and  replay.getEndHash() == world.stateHash());
+
+        std::printf("%s : %zu steps, score %d, wave %d\n", path.c_str(), stepUs.size(), world.getPlayerScore(), world.getWaveNo());
+        std::printf("  step us : mean %.2f  p50 %.2f  p99 %.2f  max %.2f  (total %.1f ms)\n", total / stepUs.size(),
+                    percentile(0.5), percentile(0.99), stepUs.back(), total / 1000.0);
+        std::printf("  state hash %016llx -> %s\n", static_cast<unsigned long long>(world.stateHash()),
+                    (not replay.hasEnd())? "NO RECORDED END (cut off file) !" : (same)? "same as recorded" : "DIFFERS FROM THE RECORDING !");
+        return same;
+    }
+
+    // record a scripted game (with key presses and held keys) and check its replay ends the same
+    bool replayCheck(unsigned int seed){
+        const char *path = "BenchmarkCheck.replay";
+        World world(1280, 720, seed);
+        InputRecorder recorder;
+        if (not recorder.open(path, world)){ std::printf("\n%s could not be written\n", path);  return false; }
+        FrameInput input;
+        for (int f = 0; f < 6000  and  not world.isGameOver(); ++f){
+            input.right = (f % 900) < 500;   input.up = (f % 700) < 100;   input.specialFire = (f % 1500) < 600;
+            input.singleFires = (f % 45 == 0);   input.fireTypeChanges = (f % 2000 == 1999);
+            recorder.record(input);
+            world.step(input);
+        }
+        recorder.close(world);
+
+        std::printf("\n--- replay : recorded a scripted game ---\n");
+        bool same = replayRun(path);
+        std::remove(path);
+        return same;
+    }
+
+
+    ////////////////////////////////// @c LARGE-WORLD-BENCHMARK //////////////////////////////////
+
+
+    // a world of 8 x 8 screens with 20000 big asteroids, the ship flying and firing across it : the steps
+    // with the far asteroids asleep against all of them stepped, the same game both ways (score, health,
+    // and every asteroid once the sleeping ones are woken), then a recorded game of that world (with its
+    // own waves) is replayed
+    bool largeWorldBenchmark(unsigned int seed){
+        const short int screens = 8;
+        const int asteroidCount = 20000, steps = 3600;
+        const char *path = "BenchmarkLarge.replay";
+        StoreLimits limits;
+        limits.asteroids = 32768;
+
+        auto script = [](int f){ // turn a bit, then fly straight for a while, firing
+            FrameInput input;
+            input.right = (f % 600) < 40;   input.up = (f % 600) >= 40;   input.specialFire = (f % 1500) < 600;
+            input.singleFires = (f % 30 == 0);
+            return input;
+        };
+        auto largeWorld = [&](bool dormant){
+            World world(1280 * screens, 720 * screens, seed, limits);
+            world.setActiveRange(1280.0F, 720.0F, dormant);
+            world.setWaveScale(screens * screens);
+            return world;
+        };
+        auto play = [&](bool dormant, std::vector<std::array<float, 4>> &left){
+            World world = largeWorld(dormant);
+            world.setShipInvulnerable(true);
+            world.startWave(asteroidCount);
+            std::size_t dormantPeak = 0;
+            auto start = BenchClock::now();
+            for (int f = 0; f < steps; ++f){
+                world.step(script(f));
+                dormantPeak = std::max(dormantPeak, world.getDormantCount());
+            }
+            double us = secondsSince(start) * 1e6 / steps;
+
+            std::printf("%10s %10.1f %9zu %9zu %6d %6d\n", (dormant)? "dormant" : "all awake", us,
+                        world.getAsteroids().size(), dormantPeak, world.getPlayerScore(), world.getWaveNo());
+            world.wakeAll();
+            const EntityStore &asteroids = world.getAsteroids();
+            for (std::size_t i = 0; i < asteroids.size(); ++i){
+                left.push_back({asteroids.x[i], asteroids.y[i], asteroids.dx[i], asteroids.dy[i]});
+            }
+            left.push_back({static_cast<float>(world.getPlayerScore()), static_cast<float>(world.getPlayerHealth()),
+                            static_cast<float>(world.getWaveNo()), -1.0F});
+            std::sort(left.begin(), left.end());
+            return us;
+        };
+
+        std::printf("\n--- large world : %d x %d screens, %d big asteroids, %d steps ---\n", screens, screens, asteroidCount, steps);
+        std::printf("%10s %10s %9s %9s %6s %6s\n", "asteroids", "step us", "stepped", "dormant", "score", "wave");
+        std::vector<std::array<float, 4>> awake, dormant;
+        double awakeUs = play(false, awake), dormantUs = play(true, dormant);
+        bool same = (awake == dormant);
+        std::printf("speedup %.2fx, the same game both ways -> %s\n", awakeUs / dormantUs, (same)? "ok" : "FAILED !");
+
+        World world = largeWorld(true);
+        InputRecorder recorder;
+        if (not recorder.open(path, world)){ std::printf("%s could not be written\n", path);  return false; }
+        for (int f = 0; f < steps  and  not world.isGameOver(); ++f){
+            recorder.record(script(f));
+            world.step(script(f));
+        }
+        recorder.close(world);
+        bool replayed = replayRun(path);
+        std::remove(path);
+        return same  and  replayed;
+    }
+
+
+    ////////////////////////////////// @c ZERO-ALLOCATION-CHECK //////////////////////////////////
+
+
+    // plays scripted games the way the front end does (the steps, the render snapshot, the explosions
+    // and trails of the effects) and fails if a frame of the steady game allocates on the heap : after
+    // a warm up, when every buffer got as big as the game needs, the frames must not allocate at all
+    bool allocationCheck(unsigned int seed){
+        const int warmUp = 3000, frames = 12000;
+        std::printf("\n--- zero allocation check : the frames after a warm up ---\n");
+
+        // every form of operator new must be counted, the over-aligned and the nothrow ones too
+        struct CacheLine { alignas(64) float values[16]; };
+        short int slot = AllocTracker::current();
+        std::uint64_t before = AllocTracker::total(slot).allocations;
+        {
+            std::vector<CacheLine> lines(4);
+            void *plain = ::operator new(64, std::nothrow);
+            void *aligned = ::operator new(64, std::align_val_t(64), std::nothrow);
+            ::operator delete(plain, std::nothrow);
+            ::operator delete(aligned, std::align_val_t(64), std::nothrow);
+        }
+        std::uint64_t counted = AllocTracker::total(slot).allocations - before;
+        std::printf("aligned and nothrow forms : %llu of 3 counted -> %s\n", static_cast<unsigned long long>(counted),
+                    (counted == 3)? "ok" : "FAILED !");
+
+        auto play = [&](const char *name, short int screens, ThreadPool *pool, short int bigWave){
+            StoreLimits limits;  limits.asteroids *= screens * screens;
+            if (bigWave > 0){ limits.bullets = 4096;  limits.asteroids = 65536; }
+            World world(1280 * screens, 720 * screens, seed, limits);
+            if (screens > 1){ world.setActiveRange(1280.0F, 720.0F);  world.setWaveScale(screens * screens); }
+            world.setShipInvulnerable(true); // (a game over would end the steady game)
+            world.setThreadPool(pool);
+            if (bigWave > 0){ world.startWave(bigWave); }
+            EffectSystem effects(4096);
+            RenderSnapshot snapshot;
+            Profiler profiler;
+
+            // (a big wave is shot down before long, so it gets fewer frames and enough shots that many
+            // steps take the parallel collision pass, the update passes are parallel all the time)
+            int warm = (bigWave > 0)? 300 : warmUp, count = (bigWave > 0)? 3000 : frames;
+            FrameInput input;
+            for (int f = 0; f < warm + count; ++f){
+                if (f == warm){ world.setProfiler(&profiler); } // only the steady frames are counted
+                input.right = (f % 900) < 500;   input.up = (f % 700) < 300;   input.specialFire = (f % 1500) < 600;
+                input.singleFires = (bigWave > 0)? 6 : (f % 45 == 0);   input.fireTypeChanges = (f % 2000 == 1999);
+                if (f >= warm){ profiler.beginFrame(); }
+                world.step(input);
+                snapshot.ship.copyDrawState(world.getShip());
+                snapshot.bullets.copyDrawState(world.getBullets());
+                snapshot.asteroids.copyDrawState(world.getAsteroids());
+                for (const EffectSpawn &spawn : world.lastEffects()){ effects.addExplosion(spawn); }
+                const EntityStore &bullets = snapshot.bullets;
+                for (std::size_t i = 0; i < bullets.size(); ++i){
+                    effects.addTrail(bullets.clip[i], bullets.frame[i], bullets.x[i], bullets.y[i], bullets.angle[i], 0.1F, 96);
+                }
+                effects.update(FRAME_SECONDS);
+                if (f >= warm){ profiler.endFrame(); }
+            }
+            std::uint64_t allocations = 0;
+            for (short int p = 0; p <= PHASE_COUNT; ++p){ allocations += profiler.getTotalAllocs(p).allocations; }
+            std::printf("%s (%d frames, score %d, wave %d) : %llu allocations -> %s\n", name, count, world.getPlayerScore(),
+                        world.getWaveNo(), static_cast<unsigned long long>(allocations), (allocations == 0)? "ok" : "FAILED !");
+            if (allocations != 0){ profiler.printAllocReport(); }
+            return allocations == 0;
+        };
+        bool classic = play("classic game", 1, nullptr, 0);
+        bool large = play("4 x 4 screen world", 4, nullptr, 0);
+        // a wave big enough for the parallel passes, on a pool as in the game (its jobs count too)
+        ThreadPool pool(4);
+        bool parallel = play("16000 asteroids on 4 workers", 1, &pool, 16000);
+        return counted == 3  and  classic  and  large  and  parallel;
+    }
+
+
+    ////////////////////////////////// @c STORE-POOL-CHECK //////////////////////////////////
+
+
+    // plays scripted games (turning and continious fire, which recharges in between)
+    // and checks no store (nor the explosions they start) ever had to grow past its capacity,
+    // then a fire type 3 storm on a big wave with a trail behind every bullet every frame, as the
+    // front end draws them (4 frames a step, a fast display) : the trails must fill the effects up and
+    // then be dropped instead of growing them
+    bool storePoolCheck(unsigned int seed){
+        const int frames = 60000;
+        World world(1280, 720, seed);
+        EffectSystem effects;
+        FrameInput input;
+        input.right = true;
+
+        auto growths = [](const World &played){
+            return played.getBullets().getGrowths() + played.getAsteroids().getGrowths();
+        };
+        int games = 1;
+        unsigned int grown = 0; // growths of the finished games
+        for (int f = 0; f < frames; ++f){
+            if (world.isGameOver()){ grown += growths(world);  world = World(1280, 720, seed + games);  ++games; }
+            input.specialFire = (f % 1500) < 600;
+            world.step(input);
+            for (const EffectSpawn &spawn : world.lastEffects()){ effects.addExplosion(spawn); }
+            effects.update(FRAME_SECONDS);
+        }
+        std::printf("\n--- store pools : %d frames, %d games (the last one below) ---\n", frames, games);
+        world.printStoreReport();
+        std::printf("%12s %8zu %8zu %8u\n", "effects", effects.getPeak(), effects.getCapacity(), effects.getGrowths());
+
+        StoreLimits limits;
+        limits.bullets = 4096;  limits.asteroids = 16384;
+        World storm(1280, 720, seed, limits);
+        storm.setShipInvulnerable(true);
+        storm.startWave(3000);
+        EffectSystem stormEffects(4096);
+        input.specialFire = true;  input.singleFires = 6;  input.fireTypeChanges = 2; // fire type 3
+        for (int f = 0; f < 1200; ++f){
+            storm.step(input);
+            input.fireTypeChanges = 0;
+            for (const EffectSpawn &spawn : storm.lastEffects()){ stormEffects.addExplosion(spawn); }
+            const EntityStore &bullets = storm.getBullets();
+            for (short int frame = 0; frame < 4; ++frame){
+                for (std::size_t i = 0; i < bullets.size(); ++i){
+                    stormEffects.addTrail(bullets.clip[i], bullets.frame[i], bullets.x[i], bullets.y[i], bullets.angle[i], 0.1F, 96);
+                }
+                stormEffects.update(FRAME_SECONDS / 4);
+            }
+        }
+        std::printf("%12s %8zu %8zu %8u  (fire storm, %lu trails dropped)\n", "effects", stormEffects.getPeak(),
+                    stormEffects.getCapacity(), stormEffects.getGrowths(), stormEffects.getDroppedTrails());
+
+        bool ok = (grown + growths(world) + effects.getGrowths() + stormEffects.getGrowths() + growths(storm) == 0)
+                  and  stormEffects.getDroppedTrails() > 0;
+        std::printf("stores stayed in their capacity -> %s\n", (ok)? "ok" : "FAILED !");
+        return ok;
+    }
+}
+
+
+int main(int argc, char *argv[]){
+    const unsigned int seed = 12345; // fixed seed, so numbers can be compared between commits
+    bool ok = true;
+
+    if (argc > 2  and  std::string(argv[1]) == "--replay"){
+        for (int i = 2; i < argc; ++i){ ok = Asteroid::replayRun(argv[i]) and ok; }
+        return (ok)? 0 : 1;
+    }
+
+    ok = Asteroid::broadphaseBenchmark(seed) and ok;
+    ok = Asteroid::kernelBenchmark(seed) and ok;
+    ok = Asteroid::randomBenchmark(seed) and ok;
+    ok = Asteroid::scenarioBenchmark(seed) and ok;
+    Asteroid::effectsBenchmark(seed);
+    ok = Asteroid::parallelBenchmark(seed) and ok;
+    ok = Asteroid::replayCheck(seed) and ok;
+    ok = Asteroid::largeWorldBenchmark(seed) and ok;
+    ok = Asteroid::allocationCheck(seed) and ok;
+    ok = Asteroid::storePoolCheck(seed) and ok;
+
+    return (ok)? 0 : 1;
+}
@@ -1,534 +1,496 @@
 
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
-#include <fstream>
-#include <memory>
-#include <random>
-#include <vector>
+#include <algorithm>
 #include <cmath>
-#include <list>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include "AssetManager.hpp"
+#include "AudioMixer.hpp"
+#include "EffectSystem.hpp"
+#include "Profiler.hpp"
+#include "ResourceCache.hpp"
+#include "ScoreStore.hpp"
+#include "SimThread.hpp"
+#include "SpriteBatch.hpp"
+#include "TextureManager.hpp"
+#include "Simulation.hpp"
 
 
 namespace Asteroid { 
     
-    sf::Texture imgBack;
-    short int fireType = 1, ith_background = 0;
-    bool inHomePage = true, spaceshipBoost = false;
-    constexpr auto DEG_TO_RAD = 0.017453F;
+    sf::Vector2u screenSize; // size of the backgrounds (and the window)
+    short int ith_background = 0;
+    
+    ResourceCache resources;                   // fonts are loaded only once
+    ScoreStore scores;                         // loaded once by main(), saved in the background
+    constexpr const char* SCORE_FILE = "AsteroidScore.txt";
+    NumberText scoreText, fireRechargeText, waveText; // prebuilt HUD texts
+    std::array<sf::Text, 3> homePageTexts;     // NEW GAME, SCORE BOARD, Change Background
+    std::string profileOutput;                 // "GAME --profile file.csv / file.json" streams the frame timings
+    bool simOnThread = false;                  // "GAME --sim-thread" steps the world on a thread of its own
+    constexpr const char* REPLAY_FILE = "LastGame.replay"; // every game's inputs (Benchmark --replay plays it again)
+    std::size_t textureBudgetMB = 64;          // "GAME --texture-budget MB" : the unused backgrounds are evicted above it
+    unsigned int gameSeed = 0;                 // "GAME --seed N" plays the same games every time (0 = seeded by the clock)
+    short int worldScreens = 1;                // "GAME --world-screens N" : a world of N x N screens, the view follows the ship
+    sf::Vector2f worldSize, cameraCenter;      // the playing area, and the middle of the view on it (see toCamera)
+    
+    enum SpriteLayer : short int { OBJECTS_LAYER, EFFECTS_LAYER, LAYER_COUNT }; // drawn from the bottom one
+    
+    // the scenes of the main loop (the splash screen runs before it, while the assets load),
+    // the wave banner and the game over go on by themselves when their time is up
+    enum Scene : short int { HOME_SCENE, PLAYING_SCENE, PAUSED_SCENE, WAVE_BANNER_SCENE, GAME_OVER_SCENE };
+    enum HomeChoice : short int { NO_CHOICE, NEW_GAME_CHOICE, SCORE_BOARD_CHOICE, BACKGROUND_CHOICE };
+    // what gameMessage() draws (TEXT_MESSAGE : the given text)
+    enum MessageId : short int {
+        TEXT_MESSAGE, INSTRUCTIONS_MESSAGE, GAME_OVER_MESSAGE, HIGH_SCORE_MESSAGE, SCORE_MESSAGE, WAVE_MESSAGE, FIRE_RECHARGE_MESSAGE
+    };
+    struct TimedMessage { MessageId id;  sf::String text;  short int number;  float seconds; }; // a gameMessage() shown for a while
+    
+    // every image and sound of the game, packed into ASSET_ARCHIVE by "GAME --pack-assets"
+    // (loaded in this order, the first ones are needed before the window opens)
+    constexpr const char* ASSET_ARCHIVE = "Assets.pak";
+    constexpr AssetFile ASSET_FILES[] = {
+        {"Images/Asteroid/icon.png",            IMAGE_ASSET,   false},
+        {"Images/Asteroid/startupimage.png",    TEXTURE_ASSET, false},
+        {"Images/Asteroid/background.jpg",      TEXTURE_ASSET, true },
+        {"Images/Asteroid/spaceship2.png",      IMAGE_ASSET,   false},
+        {"Images/Asteroid/spaceship2_.png",     IMAGE_ASSET,   false},
+        {"Images/Asteroid/bluefire.png",        IMAGE_ASSET,   false},
+        {"Images/Asteroid/redfire.png",         IMAGE_ASSET,   false},
+        {"Images/Asteroid/bigrocks.png",        IMAGE_ASSET,   false},
+        {"Images/Asteroid/smallrocks.png",      IMAGE_ASSET,   false},
+        {"Images/Asteroid/explosion1.png",      IMAGE_ASSET,   false},
+        {"Images/Asteroid/heartimage.png",      TEXTURE_ASSET, false},
+        {"Sounds/Asteroid/explosionsound1.wav", SOUND_ASSET,   false},
+        {"Sounds/Asteroid/thrustsound.wav",     SOUND_ASSET,   false},
+        {"Sounds/Asteroid/weaponsound3.wav",    SOUND_ASSET,   false},
+        {"Sounds/Asteroid/weaponsound1.wav",    SOUND_ASSET,   false},
+        {"Sounds/Asteroid/weaponsound2.wav",    SOUND_ASSET,   false},
+        // not needed at once : the big explosion sheets, and the alternate backgrounds (only on their first use)
+        {"Images/Asteroid/explosion2.png",      IMAGE_ASSET,   false},
+        {"Images/Asteroid/explosion3.png",      IMAGE_ASSET,   false},
+        {"Images/Asteroid/background2.jpg",     TEXTURE_ASSET, true,  true},
+        {"Images/Asteroid/background3.jpg",     TEXTURE_ASSET, true,  true},
+        {"Images/Asteroid/background4.jpg",     TEXTURE_ASSET, true,  true}
+    };
+    const std::array<std::string, 4> BACKGROUND_FILES = { // (strings : looked up every frame without a copy)
+        "Images/Asteroid/background.jpg",  "Images/Asteroid/background2.jpg",
+        "Images/Asteroid/background3.jpg", "Images/Asteroid/background4.jpg"
+    };
     
-    // for generate random number
-    std::mt19937 randGen(static_cast<unsigned>(std::time(nullptr)));
-    std::uniform_int_distribution<> randNo(0, 1000);
-    void loadInitialImage(sf::Texture &, sf::RenderWindow &);
-    void gameMessage(sf::String &&, short int, sf::RenderWindow &);
-    std::string getGameScore(std::string &&);
-    void setGameScores(std::string &&, std::string &&);
+    void setupTexts();
+    bool loadInitialImage(const sf::Texture &, sf::RenderWindow &, AssetManager &);
+    HomeChoice homePage(sf::RenderWindow &, bool, bool);
+    sf::String scoreBoardMessage();
+    void gameMessage(MessageId, short int, sf::RenderWindow &, const sf::String & = sf::String());
+    void updateProfileOverlay(sf::Text &, const Profiler &, const RenderSnapshot &, const EffectSystem &,
+                              const SpriteBatch &, const AudioMixer &, const TextureManager &);
     
     
     /////////////////////////////// @c ANIMATION-CLASS //////////////////////////////
     
     
-    class Animation { // use to create animation for the objects
-        
-        private : 
-        
-        short int curFrame;  float frameRate;
-        std::vector<sf::IntRect> frames; // this just stores the cords of frames
-        sf::Sprite sprite;               // to display the frame on screen
-        /*
-        imgTobeAnimate : image which contains different view frames in a linear row
-        cordX, cordY   : the inital co-ordinates for the frames
-        frameW, frameH : each frame size
-        frameCount     : total how many frames possible in the image
-        frameRate      : determines the speed of frame changing
-        */
-        public : 
-        
-        Animation(sf::Texture &imgTobeAnimate, int cordX, int cordY, 
-                int frameW, int frameH, int frameCount, float frameSpeed) noexcept {
-            
-            curFrame = 0;           // start from the first most frame
-            frameRate = frameSpeed; // set the frame changing speed
-            
-            for (short int i = 0; i < frameCount; ++i){
-                frames.push_back(sf::IntRect(cordX + i*frameW, cordY, frameW, frameH));
-                // cordX + frameW * i = goto the next frame(frame cordX = frame size * frame no.)
-            }
-            sprite.setTexture(imgTobeAnimate);
-            sprite.setOrigin(frameW / 2, frameH / 2); // set orgin for smooth rotations for rotable objects
-            sprite.setTextureRect(frames[0]);         // set the initial frame to the sprite obj
-        }
-        Animation() noexcept { curFrame = frameRate = 0; }
-        ~Animation() noexcept {}
-        
-        void update(){
-            curFrame += frameRate; // increment the frames in timely manner
-            // if the current frame reach to the last then restart
-            if (curFrame >= frames.size()){ curFrame -= frames.size(); }
-            // set the currrent frame to the sprite obj 
-            if (frames.size() > 0){ sprite.setTextureRect(frames[curFrame]); }
-        }
-        // checks if the animations is over or not
-        // if the current frame reached the last frame then animation over
-        inline bool isEnd(){ return (curFrame + frameRate  >=  frames.size()); }
-        inline sf::Sprite& getSprite(){ return sprite; }
-    };
-    
-    
-    //////////////////////////////////// @c GAME-OBJECTS //////////////////////////////////
+    // move (x, y) to its copy nearest to the camera (the world wraps around), false if that is out of
+    // the view by more than reach (then it is not drawn at all)
+    inline bool toCamera(float &x, float &y, float reach){
+        if (x - cameraCenter.x > worldSize.x / 2){ x -= worldSize.x; }
+        else if (cameraCenter.x - x > worldSize.x / 2){ x += worldSize.x; }
+        if (y - cameraCenter.y > worldSize.y / 2){ y -= worldSize.y; }
+        else if (cameraCenter.y - y > worldSize.y / 2){ y += worldSize.y; }
+        return std::abs(x - cameraCenter.x) < screenSize.x / 2 + reach  and  std::abs(y - cameraCenter.y) < screenSize.y / 2 + reach;
+    }
     
     
-    class GameObject { // a base class for all movable game objects
-        friend void Main();
-        friend bool isCollided(const std::shared_ptr<GameObject>&, const std::shared_ptr<GameObject>&);
+    class Animation { // use to draw the animation frames of the objects
         
-        protected : 
+        private : 
         
-        bool life;
-        sf::String name;
-        float x, y, dx, dy, angle, R;
-        Animation animation;
+        std::vector<TextureAtlas::Frame> frames; // this just stores the page and cords of every frame
+        float originX, originY;                  // rotation origin (the middle of a frame)
         /*
-        name         : a particular name that defines the object
-        life         : that defines the object is collided and alive or not
-        x , y        : current co-ordinates of the object
-        dx , dy      : future co-ordinates of the object
-        angle        : a angle in which direction the object is moving
-        animation    : to define the animations of the objects
-        R            : a optional value for visualizing collisions
+        sheet : where the frames of the image (a linear row in the file) were repacked in the atlas,
+                in rows of a block and maybe over more pages, so every frame keeps its own place
+        clip  : the shared clip (frame size and count), only one Animation is built per clip
+        (the frame speed and the current frame of every obj are kept by the simulation, see Simulation.hpp)
         */
-        GameObject(sf::String &&objName) noexcept { 
-            name = objName;  life = true;  x = y = dx = dy = angle = R = 0.0F; 
-        }
         public : 
         
-        virtual ~GameObject() noexcept {};
-        virtual void update(){};
-        
-        void settings(Animation &anim, int X, int Y, float degree = 1, int radious = 0){
-            animation = anim;  x = X;  y = Y;  angle = degree;  R = radious;
-        }
-        void draw(sf::RenderWindow &window){    // draw the obj to the window
-            this->animation.getSprite().setPosition(x, y);
-            this->animation.getSprite().setRotation(angle + 90.0F);
-            window.draw(animation.getSprite()); // draw a particular frame to the window
+        Animation(const std::vector<TextureAtlas::Frame> &sheet, const AnimationClip &clip) noexcept {
             
-            sf::CircleShape circle(R);
-            circle.setPosition(x, y);
-            circle.setOrigin(R, R);
-            // ------ optional part for debugging collison detections -------
-            // circle.setFillColor(sf::Color::Cyan);
-            // window.draw(circle);
+            frames = sheet; // frame i of the clip is frame i of the sheet, wherever the atlas put it
+            originX = clip.frameW / 2;  originY = clip.frameH / 2; // set orgin for smooth rotations for rotable objects
         }
-    };
-    
-    
-    ////////////////////////////////// @c SPACESHIP-CLASS //////////////////////////////////
-    
-    
-    class SpaceShip : public GameObject {
-        
-        public  :
-        
-        SpaceShip() noexcept : GameObject("spaceship"){}
-        ~SpaceShip() noexcept {}
+        Animation() noexcept { originX = originY = 0.0F; }
+        ~Animation() noexcept {}
         
-        void update(){
-            if (spaceshipBoost){ // if user boosted the ship by up-arraow then increase speed
-                dx += std::cos(angle * DEG_TO_RAD) * 0.2F;
-                dy += std::sin(angle * DEG_TO_RAD) * 0.2F;
+        // add a particular frame of the animation for the i'th obj of a store to the sprite batch,
+        // drawn at "alpha" of the way from its previous step to its current one
+        void draw(const EntityStore &store, std::size_t i, SpriteBatch &batch, SpriteLayer layer, float alpha){
+            if (frames.empty()){ return; }
+            float x = store.x[i], y = store.y[i], angle = store.angle[i];
+            float moveX = x - store.prevX[i], moveY = y - store.prevY[i], turn = angle - store.prevAngle[i];
+            // not across the world when the obj just wrapped around it
+            if (std::abs(moveX) < worldSize.x / 2  and  std::abs(moveY) < worldSize.y / 2){
+                x -= moveX * (1.0F - alpha);  y -= moveY * (1.0F - alpha);
             }
-            else { dx *= 0.99F;  dy *= 0.99F; } // otherwise decrease the speed gradually
-            
-            // prevent the ship speed to become too much fast
-            float maxSpeed = 5.0F, speed = std::sqrt(dx * dx  +  dy * dy);
-            if (speed > maxSpeed){ dx *= maxSpeed / speed;  dy *= maxSpeed / speed; }
-            
-            x += dx;  y += dy;
-            
-            // screen wrapping 
-            // if the ship moves off one side of the screen then it reappears on other side
-            if (x < 0.0F){ x = imgBack.getSize().x; }
-            if (y < 0.0F){ y = imgBack.getSize().y; }
-            if (x > imgBack.getSize().x){ x = 0.0F; }
-            if (y > imgBack.getSize().y){ y = 0.0F; }
-        }
-    };
-    
-    
-    ////////////////////////////////// @c BULLET-CLASS //////////////////////////////////
-    
-    
-    class Bullet : public GameObject {
-        
-        public : 
-        
-        Bullet() noexcept : GameObject("bullet"){}
-        ~Bullet() noexcept {}
-        
-        void update(){
-            dx += std::cos(angle * DEG_TO_RAD) * 1.0F; // calculate the velocity horizontal
-            dy += std::sin(angle * DEG_TO_RAD) * 1.0F; // calculate the velocity vertically
-            x += dx;   y += dy;                        // updae to the actual co-ordinates
-            // change the fire types but not effect the single fire type 
-            if (fireType == 2  and  R == 11){ angle += randNo(randGen) % 7 - 3; }
-            if (fireType == 3  and  R == 11){ angle += randNo(randGen); }
-            // if go out of bound then remove that bullet obj
-            if (x < 0  or  x > imgBack.getSize().x){ life = false; }
-            if (y < 0  or  y > imgBack.getSize().y){ life = false; }
-        }
-    };
-    
-    
-    ////////////////////////////////// @c ASTEROID-CLASS //////////////////////////////////
-    
-    
-    class Asteroid : public GameObject {
-        
-        public :
-        
-        Asteroid() noexcept : GameObject("asteroid"){ 
-            dx = randNo(randGen) % 3; // spawn a asteroid with random values
-            dy = randNo(randGen) % 3; // (%5) to limit the asteroids movement speed
+            if (not toCamera(x, y, 1.5F * std::max(originX, originY))){ return; } // (a rotated frame reaches ~1.41 x)
+            if (std::abs(turn) < 45.0F){ angle -= turn * (1.0F - alpha); } // not the random spins of fire type 3
+            const TextureAtlas::Frame &frame = frames[store.frame[i] % frames.size()];
+            batch.add(layer, frame.page, frame.rect, originX, originY, x, y, angle + 90.0F);
+            // ------ optional part for debugging collison detections -------
+            // sf::CircleShape circle(store.R[i]);  circle.setPosition(store.x[i], store.y[i]);
+            // circle.setOrigin(store.R[i], store.R[i]);  circle.setFillColor(sf::Color::Cyan);  window.draw(circle);
         }
-        ~Asteroid() noexcept {}
-        
-        void update(){
-            x += dx;   y += dy; // update the actual co-ordinates
-            // screen wrapping (same like the spaceship)
-            if (x < 0.0F){ x = imgBack.getSize().x; }
-            if (y < 0.0F){ y = imgBack.getSize().y; }
-            if (x > imgBack.getSize().x){ x = 0.0F; }
-            if (y > imgBack.getSize().y){ y = 0.0F; }
+        // the same for the i'th visual effect (it already moves on the frame time, so no interpolation)
+        void draw(const EffectSystem &effects, std::size_t i, SpriteBatch &batch, SpriteLayer layer){
+            if (frames.empty()){ return; }
+            float x = effects.x[i], y = effects.y[i];
+            if (not toCamera(x, y, 1.5F * std::max(originX, originY))){ return; }
+            const TextureAtlas::Frame &frame = frames[effects.frameOf(i) % frames.size()];
+            batch.add(layer, frame.page, frame.rect, originX, originY, x, y, effects.angle[i] + 90.0F,
+                      sf::Color(255, 255, 255, effects.alphaOf(i)));
         }
     };
     
     
-    ////////////////////////////////// @c EXPLOSION-CLASS //////////////////////////////////
-    
-    
-    class Explosion : public GameObject {  public :
-        
-        Explosion() noexcept : GameObject("explosion"){}
-        ~Explosion() noexcept {}
-    };
-    
-    
-    ////////////////////////////////// @c COLLISION-DETECTION-FUNCTION //////////////////////////////////
-    
-    
-    bool isCollided(const std::shared_ptr<GameObject> &obj1, const std::shared_ptr<GameObject> &obj2){
-        
-        // collision check between two objs using maths ---circle distance formula---
-        auto distanceSquareX = (obj1->x - obj2->x) * (obj1->x - obj2->x);
-        auto distanceSquareY = (obj1->y - obj2->y) * (obj1->y - obj2->y);
-        auto distanceSquareR = (obj1->R + obj2->R) * (obj1->R + obj2->R); // R -> radious
-        
-        return (distanceSquareX + distanceSquareY  <  distanceSquareR);
-    }
-    
-    
     void Main(){
         using namespace sf;
         
-        Image       icon;  
-        Texture     imgStartUp, imgBack2, imgBack3, imgBack4, imgSpaceship, imgSpaceshipBoost, imgBlueFire, imgRedFire, 
-                    imgBigAsteroids, imgSmallAsteroids, imgExplosion1, imgExplosion2, imgExplosion3, imgHealth;
-        SoundBuffer explosion1SBuffer, shipBoostSBuffer, singleFireSBuffer, specialFireSBuffer1, specialFireSBuffer2;
-        
-        imgStartUp.loadFromFile         ("Images/Asteroid/startupimage.png");
-        icon.loadFromFile               ("Images/Asteroid/icon.png");
-        imgBack.loadFromFile            ("Images/Asteroid/background.jpg");
-        imgBack2.loadFromFile           ("Images/Asteroid/background2.jpg");
-        imgBack3.loadFromFile           ("Images/Asteroid/background3.jpg");
-        imgBack4.loadFromFile           ("Images/Asteroid/background4.jpg");
-        imgSpaceship.loadFromFile       ("Images/Asteroid/spaceship2.png");
-        imgSpaceshipBoost.loadFromFile  ("Images/Asteroid/spaceship2_.png");
-        imgBlueFire.loadFromFile        ("Images/Asteroid/bluefire.png");
-        imgRedFire.loadFromFile         ("Images/Asteroid/redfire.png");
-        imgBigAsteroids.loadFromFile    ("Images/Asteroid/bigrocks.png");
-        imgSmallAsteroids.loadFromFile  ("Images/Asteroid/smallrocks.png");
-        imgExplosion1.loadFromFile      ("Images/Asteroid/explosion1.png");
-        imgExplosion2.loadFromFile      ("Images/Asteroid/explosion2.png");
-        imgExplosion3.loadFromFile      ("Images/Asteroid/explosion3.png");
-        imgHealth.loadFromFile          ("Images/Asteroid/heartimage.png");
-        explosion1SBuffer.loadFromFile  ("Sounds/Asteroid/explosionsound1.wav");
-        shipBoostSBuffer.loadFromFile   ("Sounds/Asteroid/thrustsound.wav");
-        singleFireSBuffer.loadFromFile  ("Sounds/Asteroid/weaponsound3.wav");
-        specialFireSBuffer1.loadFromFile("Sounds/Asteroid/weaponsound1.wav");
-        specialFireSBuffer2.loadFromFile("Sounds/Asteroid/weaponsound2.wav");
-        
-        imgBack.setSmooth     (true);    imgBack2.setSmooth(true);
-        imgBack3.setSmooth    (true);    imgBack4.setSmooth(true);
-        imgSpaceship.setSmooth(true);
+        // the assets are decoded on worker threads (in this order), critical ones first so the
+        // window and the splash screen can start while the rest is still loading in the background
+        ThreadPool   workers;  // later it also splits the collision and update passes of very big waves
+        AssetManager assets(workers, ASSET_ARCHIVE);
+        for (const AssetFile &file : ASSET_FILES){ if (not file.onDemand){ assets.load(file); } }
+        // the textures are counted against a budget, the ones not pinned may be evicted when it is full
+        TextureManager textures(assets, textureBudgetMB * 1048576);
+        Image   &icon       = assets.image  ("Images/Asteroid/icon.png");
+        const Texture &imgStartUp = textures.pin("Images/Asteroid/startupimage.png");
+        screenSize = textures.pin(BACKGROUND_FILES[0], true).getSize();
         
         // ------------------- creating the main game window -------------------
-        RenderWindow window(VideoMode(imgBack.getSize().x, imgBack.getSize().y), "Asteroid !...");
+        RenderWindow window(VideoMode(screenSize.x, screenSize.y), "Asteroid !...");
         window.setIcon(icon.getSize().x, icon.getSize().y, icon.getPixelsPtr());
         window.setFramerateLimit(120);
-        loadInitialImage(imgStartUp, window); // load the initial image for the game
+        // load the initial image for the game (false if the window was closed meanwhile)
+        if (not loadInitialImage(imgStartUp, window, assets)){ return; }
+        textures.release("Images/Asteroid/startupimage.png"); // never shown again
+        setupTexts();                                 // build the HUD and home page texts once
+        
+        const Texture &imgHealth         = textures.pin("Images/Asteroid/heartimage.png");
+        SoundBuffer &explosion1SBuffer   = assets.sound  ("Sounds/Asteroid/explosionsound1.wav"),
+                    &shipBoostSBuffer    = assets.sound  ("Sounds/Asteroid/thrustsound.wav"),
+                    &singleFireSBuffer   = assets.sound  ("Sounds/Asteroid/weaponsound3.wav"),
+                    &specialFireSBuffer1 = assets.sound  ("Sounds/Asteroid/weaponsound1.wav"),
+                    &specialFireSBuffer2 = assets.sound  ("Sounds/Asteroid/weaponsound2.wav");
+        
+        // repack the frames of all the sprite sheets into atlas pages (never bigger than the GPU allows),
+        // every page is then drawn with one call per layer (2048 pages waste less than one 4096 page)
+        TextureAtlas atlas;
+        std::vector<TextureAtlas::Sheet> sheets;
+        for (const AnimationClip &clip : CLIPS){
+            sheets.push_back({clip.sheet, &assets.image(clip.sheet), clip.frameW, clip.frameH, clip.frameCount});
+        }
+        atlas.build(sheets, std::min(2048U, Texture::getMaximumSize()));
+        for (const AnimationClip &clip : CLIPS){ assets.releaseImage(clip.sheet); }
+        for (short int page = 0; page < static_cast<short int>(atlas.pageCount()); ++page){
+            textures.track("atlas page " + std::to_string(page), atlas.pageBytes(page));
+        }
+        SpriteBatch sprites(atlas, LAYER_COUNT);
+        assets.printReport(); // every asset of the start is in by now (the sprite sheets were the last ones)
         
-        std::array<Sprite, 4>       background;
-        background[0].setTexture    (imgBack);
-        background[1].setTexture    (imgBack2);
-        background[2].setTexture    (imgBack3);
-        background[3].setTexture    (imgBack4);
+        // only the chosen background is drawn, the next one is decoded meanwhile (so changing it doesn't wait)
+        Sprite background;
+        textures.prefetch(BACKGROUND_FILES[1], true);
         Sprite playerHealth         (imgHealth);
         
-        Animation spaceShipAnim     (imgSpaceship,      0, 0,  45,  50,  1, 1);
-        Animation spaceShipBoostAnim(imgSpaceshipBoost, 0, 0,  45,  70,  1, 1);
-        Animation blueBulletAnim    (imgBlueFire,       0, 0,  32,  64, 16, 1);
-        Animation redBulletAnim     (imgRedFire,        0, 0,  32,  64, 16, 0);
-        Animation bigAsteroidAnim   (imgBigAsteroids,   0, 0,  64,  64, 16, 0);
-        Animation smallAsteroidAnim (imgSmallAsteroids, 0, 0,  64,  64, 16, 0);
-        Animation explosionAnim_1   (imgExplosion1,     0, 0,  50,  50, 20, 1);
-        Animation explosionAnim_2   (imgExplosion2,     0, 0, 192, 192, 64, 1);
-        Animation explosionAnim_3   (imgExplosion3,     0, 0, 256, 256, 48, 1);
-        
-        Sound explosionSound1  (explosion1SBuffer);
-        Sound shipBoostSound   (shipBoostSBuffer);
-        Sound singleFireSound  (singleFireSBuffer);
-        Sound specialFireSound1(specialFireSBuffer1);
-        Sound specialFireSound2(specialFireSBuffer2);
-        
-        singleFireSound.setPitch  (2.0F);    singleFireSound.setVolume  (10.0F);
-        specialFireSound1.setPitch(2.0F);    specialFireSound1.setVolume(10.0F);
-        specialFireSound2.setPitch(2.0F);    specialFireSound2.setVolume(10.0F);
-        shipBoostSound.setPitch   (2.0F);    shipBoostSound.setVolume   (12.5F);
-        
-        // std::list<GameObject*> gameObjs;
-        std::list<std::shared_ptr<GameObject>> gameObjs;
+        // indexed by the simulation's ClipId
+        std::array<Animation, CLIP_COUNT> animations;
+        for (short int clip = 0; clip < CLIP_COUNT; ++clip){
+            animations[clip] = Animation(atlas.region(CLIPS[clip].sheet), CLIPS[clip]);
+        }
         
-        // GameObject *spaceshipObj = new SpaceShip(); // space ship obj
-        std::shared_ptr<GameObject> spaceshipObj = std::make_shared<SpaceShip>();
-        spaceshipObj->settings(spaceShipAnim, 400, 400, 0, 20);
-        gameObjs.push_back(spaceshipObj);
+        // every effect gets a few voices (how many of it can overlap), the more important sounds may
+        // steal a voice : (buffer, voices, priority, pitch, volume, a busy voice may be restarted)
+        AudioMixer mixer;
+        short int explosionSound1   = mixer.addEffect(explosion1SBuffer,   2, 3, 1.0F, 100.0F, true);
+        short int singleFireSound   = mixer.addEffect(singleFireSBuffer,   4, 2, 2.0F,  10.0F, true);
+        short int specialFireSound1 = mixer.addEffect(specialFireSBuffer1, 1, 1, 2.0F,  10.0F, false);
+        short int specialFireSound2 = mixer.addEffect(specialFireSBuffer2, 1, 1, 2.0F,  10.0F, false);
+        short int shipBoostSound    = mixer.addEffect(shipBoostSBuffer,    1, 1, 2.0F,  12.5F, false);
+        
+        // all the game objects and rules live in the (window free) simulation, stepped in fixed steps :
+        // every frame runs as many steps as the real time needs (none on a fast frame, several on a slow one)
+        // and draws the latest snapshot, the objects in between their last two steps
+        // (with "--sim-thread" the steps run on their own thread while this one draws)
+        auto nextSeed = [](){ return (gameSeed != 0)? gameSeed++ : static_cast<unsigned>(std::time(nullptr)); };
+        worldSize = sf::Vector2f(screenSize.x * worldScreens, screenSize.y * worldScreens);
+        cameraCenter = sf::Vector2f(screenSize.x / 2.0F, screenSize.y / 2.0F);
+        StoreLimits limits;  limits.asteroids *= worldScreens * worldScreens;
+        SimThread sim(worldSize.x, worldSize.y, nextSeed(), limits);
+        if (worldScreens > 1){
+            // a large world : only the screens around the ship are stepped, the farther asteroids sleep
+            // (and the waves are as many times bigger as the world has screens)
+            sim.getWorld().setActiveRange(screenSize.x, screenSize.y);
+            sim.getWorld().setWaveScale(worldScreens * worldScreens);
+        }
+        EffectSystem effects(4096); // the explosions and trails, only drawn (they never touch the game objects)
+        View camera(FloatRect(0.0F, 0.0F, screenSize.x, screenSize.y)); // the game objects are drawn through it
+        if (not sim.record(REPLAY_FILE)){ std::printf("%s could not be written\n", REPLAY_FILE); }
+        
+        // F3 shows the frame timings, "--profile" also writes them for every frame into a file
+        Profiler profiler;
+        if (not profileOutput.empty()  and  not profiler.openTrace(profileOutput)){
+            std::printf("profile trace %s could not be written\n", profileOutput.c_str());
+        }
+        if (not simOnThread){ sim.getWorld().setProfiler(&profiler); } // the profiler is not thread safe
+        sim.getWorld().setThreadPool(&workers);
+        Text profileOverlay("", resources.getFont(CAMBRIA_FONT), 14);
+        profileOverlay.setFillColor(Color::White);  profileOverlay.setPosition(10, 40);
+        bool showProfile = false;
         
         ///////////////////////////////// @c MAIN-LOOP /////////////////////////////////
         
+        // the game is a small state machine of scenes : every frame pumps the events, updates the current
+        // scene and draws it, the timed messages (wave banner, game over, score board, instructions) count
+        // down with the frame time instead of sleeping, and a new game restarts the simulation in place
+        Scene scene = HOME_SCENE;
+        TimedMessage message = {TEXT_MESSAGE, "", 0, 0.0F}; // shown over the home page while its seconds last
+        float sceneSeconds = 0.0F;            // what is left of a timed scene
+        bool highScoreBeaten = false, gamePlayed = false;
+        short int waveNo = 0; // counted from the events (the snapshot may be a step behind them)
         // if the players high score not set, then it means player plays the game for the first time
-        bool gamePause = false, startUpInstructionsLoaded = (getGameScore("HighestScore")=="0")? false:true;
-        short int playerHealthCount = 5,  playerScore = 0, waveLength = 0, waveNo = 0;
-        Clock inputClock, fireClock, fireHoldClock;                            // timer clocks for hold inputs and 
-        bool inputBlocked = false, continiousFireOn = false, holdFire = false; // flags for timers
+        if (scores.getHighScore() == 0){ message = {INSTRUCTIONS_MESSAGE, "", 0, 20.0F}; }
+        sim.start(simOnThread);
         
+        Clock frameClock;
         Event e;
         while (window.isOpen()){
+            float frameSeconds = frameClock.restart().asSeconds();
+            textures.nextFrame();
+            FrameInput input; // collect this frame's inputs for the simulation
+            bool clicked = false, anyKey = false, enterPressed = false;
+            profiler.beginFrame();
+            ProfileScope frameTimer(&profiler, EVENTS_PHASE);
+            
             while (window.pollEvent(e)){
                 if (e.type == Event::Closed){ window.close(); }
-                if (e.type == Event::LostFocus){ gamePause = true; }
-                if (e.type == Event::GainedFocus){ gamePause = false; }
-                
-                
-                ////////////////////////// @c DIFFERENT-TYPE-BULLET-SHOOT-LOGIC /////////////////////////
-                
+                if (e.type == Event::LostFocus  and  scene == PLAYING_SCENE){ scene = PAUSED_SCENE; }
+                if (e.type == Event::GainedFocus  and  scene == PAUSED_SCENE){ scene = PLAYING_SCENE; }
+                if (e.type == Event::MouseButtonPressed  and  e.mouseButton.button == Mouse::Left){ clicked = true; }
                 
                 if (e.type == Event::KeyPressed){
-                    if (e.key.code == Keyboard::Space  and  not inputBlocked){ 
-                        
-                        // create a new single bullet obj on space key input
-                        std::shared_ptr<GameObject> bulletObj = std::make_shared<Bullet>();
-                        bulletObj->settings(blueBulletAnim, spaceshipObj->x, spaceshipObj->y, spaceshipObj->angle, 10);
-                        gameObjs.push_back(bulletObj);
-                        // play the single bullet fire sound
-                        // only play the sound if it is not the sound is currently playing 
-                        // (it actually maintain the sound effect properly)
-                        if (singleFireSound.getStatus() != Sound::Playing){ singleFireSound.play(); }
-                        else { singleFireSound.stop(); }
-                    }
-                    // changes the fire type upon keyboard down key press
-                    else if (e.key.code == Keyboard::Down){ ++fireType;  if (fireType >= 4) fireType = 1; }
-                    
-                    else if (e.key.code == Keyboard::LShift  and  not continiousFireOn){
-                        fireClock.restart();  continiousFireOn = true; // shift hold for continious fire
-                    }
+                    anyKey = true;
+                    if (e.key.code == Keyboard::Space){ ++input.singleFires; }
+                    else if (e.key.code == Keyboard::Down){ ++input.fireTypeChanges; }
+                    else if (e.key.code == Keyboard::Return){ enterPressed = true; }
+                    else if (e.key.code == Keyboard::F3){ showProfile = not showProfile; }
                 }
-                if (e.type == Event::KeyReleased){ // shift released continious fire off
-                    if (e.key.code == Keyboard::LShift){ continiousFireOn = false; }
-                }
-            }
-            if (not startUpInstructionsLoaded){
-                gameMessage("gameInstructions", 20, window);  startUpInstructionsLoaded = true;
             }
+            input.specialFire = Keyboard::isKeyPressed(Keyboard::LShift);
+            input.right       = Keyboard::isKeyPressed(Keyboard::Right);
+            input.left        = Keyboard::isKeyPressed(Keyboard::Left);
+            input.up          = Keyboard::isKeyPressed(Keyboard::Up);
+            frameTimer.stop(); // the step times its own phases
+            
             "----------------------------------- start game logic and calculations ---------------------------------";
             
-            if (not gamePause  and  not inHomePage){
-                
-                if (not inputBlocked  and  continiousFireOn  and  not holdFire){ 
-                    
-                    // create a new continious bullet obj
-                    std::shared_ptr<GameObject> bulletObj = std::make_shared<Bullet>();
-                    bulletObj->settings((fireType == 1)? blueBulletAnim : redBulletAnim, 
-                                        spaceshipObj->x, spaceshipObj->y, spaceshipObj->angle, 11);
-                    gameObjs.push_back(bulletObj);
-                    
-                    switch (fireType){ // play the continious fire sound based on the fire type
-                        case 1 :    if (specialFireSound1.getStatus() != Sound::Playing){ 
-                                        specialFireSound1.play(); 
-                                    } break;
-                        case 2 :    if (specialFireSound2.getStatus() != Sound::Playing){ 
-                                        specialFireSound2.play(); 
-                                    } break;
-                        case 3 :    if (specialFireSound2.getStatus() != Sound::Playing){ 
-                                        specialFireSound2.play(); 
-                                    } break;
-                    }
-                    // continue the continious fire upto 3 seonds then block it for recharge
-                    if (fireClock.getElapsedTime() >= seconds(3)){ 
-                        holdFire = true;  fireHoldClock.restart(); 
-                    }
-                }
-                else { // restart the continious fire after recharged for 10 seconds
-                    if (fireHoldClock.getElapsedTime() >= seconds(10)){ holdFire = false; }
+            // only the playing scene steps the sim (paused it drops the key presses, and the paused time is not simulated later)
+            sim.setPaused(scene != PLAYING_SCENE);
+            sim.sendInput(input);
+            const RenderSnapshot &snapshot = sim.latest();
+            float alpha = sim.alphaOf(snapshot); // how far the objects are drawn from their last step to the next
+            float shipX = (snapshot.ship.size() > 0)? snapshot.ship.x[0] : screenSize.x / 2.0F;
+            float shipY = (snapshot.ship.size() > 0)? snapshot.ship.y[0] : screenSize.y / 2.0F;
+            if (worldScreens > 1  and  snapshot.ship.size() > 0){ // the camera follows the ship (where it is drawn)
+                const EntityStore &ship = snapshot.ship;
+                float moveX = ship.x[0] - ship.prevX[0], moveY = ship.y[0] - ship.prevY[0];
+                cameraCenter = sf::Vector2f(ship.x[0], ship.y[0]);
+                if (std::abs(moveX) < worldSize.x / 2  and  std::abs(moveY) < worldSize.y / 2){
+                    cameraCenter.x -= moveX * (1.0F - alpha);  cameraCenter.y -= moveY * (1.0F - alpha);
                 }
-                
-                /////////////////////////// @c SHIP-MOVEMENT-LOGIC //////////////////////////
-                
-                
-                if (not inputBlocked  and  Keyboard::isKeyPressed(Keyboard::Right)){ spaceshipObj->angle += 2.9F; }
-                if (not inputBlocked  and  Keyboard::isKeyPressed(Keyboard::Left)){  spaceshipObj->angle -= 2.9F; }
-                // cahnging the space ship image based on enable/disable boost of the space ship
-                if (not inputBlocked  and  Keyboard::isKeyPressed(Keyboard::Up)){ 
-                    spaceshipBoost = true;  
-                    spaceshipObj->animation = spaceShipBoostAnim;
-                    // play the spaceship boost sound
-                    if (shipBoostSound.getStatus() != Sound::Playing){ shipBoostSound.play(); }
+            }
+            camera.setCenter(cameraCenter);
+            mixer.setListener(cameraCenter.x, cameraCenter.y);
+            
+            ////////////////////////// @c SCENE-UPDATE /////////////////////////
+            
+            
+            if (scene == HOME_SCENE  and  message.seconds > 0.0F){ // any key or click closes the message earlier
+                message.seconds -= frameSeconds;
+                if (anyKey  or  clicked){ message.seconds = 0.0F; }
+            }
+            else if (scene == HOME_SCENE){
+                HomeChoice choice = homePage(window, clicked, enterPressed);
+                if (choice == NEW_GAME_CHOICE){
+                    // the assets stay loaded, only the world starts again
+                    if (gamePlayed){ sim.restart(nextSeed());  waveNo = 0;  effects.clear(); }
+                    gamePlayed = true;  scene = PLAYING_SCENE;
                 }
-                else { spaceshipBoost = false;  spaceshipObj->animation = spaceShipAnim;  shipBoostSound.stop(); }
-                
-                
-                ///////////////////////// @c COLLISION-DETECTION-LOGIC-AND-INPUT-HOLD ////////////////////////
-                
-                
-                for (auto &obj1 : gameObjs){
-                    for (auto &obj2 : gameObjs){
-                        
-                        if (obj1->name == "bullet"  and  obj2->name == "asteroid"){
-                            if ( isCollided(obj1, obj2) ){
-                                
-                                obj1->life = obj2->life = false; 
-                                // if R = 10, means it is already a small asteroid, so not break it furthur
-                                if (obj2->R != 10){ // this refer to big asteroids
-                                    obj2->name = "break_this_asteroid"; 
-                                    ++playerScore; // increment the if only a big asteroid destroyed
-                                }
-                                // create a explosion effect based on the asteroid type
-                                std::shared_ptr<GameObject> explosionObj = std::make_shared<Explosion>();
-                                explosionObj->settings((obj2->R == 10)? explosionAnim_1 : explosionAnim_2, obj2->x, obj2->y);
-                                gameObjs.push_back(explosionObj);
-                            }
-                        }
-                        else if (obj1->name == "spaceship"  and  obj2->name == "asteroid"){
-                            if ( isCollided(obj1, obj2) ){
-                                
-                                // upon collision between player and asteroid
-                                obj2->life = false;       --playerHealthCount; 
-                                // create a different explosion effect for the spaceship colliding
-                                std::shared_ptr<GameObject> explosionObj = std::make_shared<Explosion>();
-                                explosionObj->settings(explosionAnim_3, obj1->x, obj1->y);
-                                gameObjs.push_back(explosionObj);
-                                
-                                // play the sound when  player collided with an  asteroid
-                                if (explosionSound1.getStatus() != Sound::Playing){ explosionSound1.play(); }
-                                else { explosionSound1.stop(); }
-                                
-                                // block the ship movements after the collsion for some times by holding keyboard inputs
-                                inputBlocked = true;  inputClock.restart();
-                                spaceshipObj->dx = spaceshipObj->dy = 0;
-                                
-                                "------------------ Game Over Logic -----------------";
-                                if (playerHealthCount <= 0){ 
-                                    gameMessage("gameOver", 2, window);  
-                                    if (playerScore > std::stoi(getGameScore("HighestScore"))){
-                                        gameMessage("gameHighScore", 2, window);  
-                                    }
-                                    throw playerScore;
-                                }
-                            }
-                        }
-                    }
+                else if (choice == SCORE_BOARD_CHOICE){ message = {TEXT_MESSAGE, scoreBoardMessage(), 0, 3.0F}; }
+                else if (choice == BACKGROUND_CHOICE){
+                    ++ith_background;  if (ith_background >= 4){ ith_background = 0; }
+                    textures.prefetch(BACKGROUND_FILES[(ith_background + 1) % 4], true);
                 }
-                // released the input flag and again allow keyboard inputs after holding for 1/2 seconds
-                if (inputBlocked  and  inputClock.getElapsedTime() >= seconds(0.5)){ inputBlocked = false; }
-                
-                
-                ////// @c REMOVE-THE-EXPLOSION-OBJ'S-AFTER-ANIMATION,-AND-SPAWN-NEW-SMALL-ASTEROIDS ///////
-                
-                
-                for (auto &obj : gameObjs){
-                    if (obj->name == "explosion"){
-                        if (obj->animation.isEnd()){ obj->life = false; }
-                    }
-                    if (obj->name == "break_this_asteroid"){
-                        for (short int i = 0; i < 4; ++i){
-                            std::shared_ptr<GameObject> smallAsteroidObj = std::make_shared<Asteroid>();
-                            smallAsteroidObj->settings(smallAsteroidAnim, obj->x, obj->y, randNo(randGen)%360, 10);
-                            gameObjs.push_back(smallAsteroidObj);
-                        }
-                    }
+            }
+            else if (scene == WAVE_BANNER_SCENE  or  scene == GAME_OVER_SCENE){
+                sceneSeconds -= frameSeconds;
+                if (sceneSeconds <= 0.0F){ scene = (scene == WAVE_BANNER_SCENE)? PLAYING_SCENE : HOME_SCENE; }
+            }
+            
+            // the sounds are only queued here, the mixer starts them once after the events
+            // (a wave banner or the game over leaves the rest of the events for later)
+            GameEvent event;
+            while (scene == PLAYING_SCENE  and  sim.popEvent(event)){
+                switch (event){
+                    case SINGLE_FIRE_EVENT :    mixer.play(singleFireSound, shipX, shipY);    break;
+                    case SPECIAL_FIRE_EVENT_1 : mixer.play(specialFireSound1, shipX, shipY);  break;
+                    case SPECIAL_FIRE_EVENT_2 : mixer.play(specialFireSound2, shipX, shipY);  break;
+                    // play the sound when  player collided with an  asteroid
+                    case SHIP_HIT_EVENT :       mixer.play(explosionSound1, shipX, shipY);    break;
+                    case NEW_WAVE_EVENT :       scene = WAVE_BANNER_SCENE;  sceneSeconds = 2.0F;  ++waveNo;
+                                                break;
+                    case GAME_OVER_EVENT :      // ------------------ game over logic -----------------
+                                                sim.stop();  // the world doesn't change anymore
+                                                highScoreBeaten = sim.getWorld().getPlayerScore() > scores.getHighScore();
+                                                scores.submit(sim.getWorld().getPlayerScore()); // saved meanwhile
+                                                sim.getWorld().printStoreReport();
+                                                scene = GAME_OVER_SCENE;  sceneSeconds = (highScoreBeaten)? 4.0F : 2.0F;
+                                                break;
                 }
-                
-                ///////////////////////// @c ALL-OBJECTS-UPDATE-LOGIC-FOR-EACH-FRAME ////////////////////////
-                
-                
-                // update the game objects one by one and remove if not needed
-                for (auto it = gameObjs.begin(); it != gameObjs.end(); ){
-                    auto eachObj = *it;
-                    
-                    eachObj->update();
-                    eachObj->animation.update();
-                    // erase current and points to the next element
-                    if (not eachObj->life){ it = gameObjs.erase(it); }
-                    else { ++it; } // manually increment the iterator, if obj life is true
+            }
+            // play the spaceship boost sound (not restarted while it still plays)
+            if (scene == PLAYING_SCENE  and  snapshot.boosting){ mixer.play(shipBoostSound, shipX, shipY); }
+            else { mixer.stop(shipBoostSound); }
+            mixer.update();
+            
+            // the effects move on the frame time : the explosions the steps started, a fading trail behind
+            // every bullet and a puff behind the boosting ship (paused, they stay as they are)
+            EffectSpawn spawn;
+            while (scene == PLAYING_SCENE  and  sim.popEffect(spawn)){ effects.addExplosion(spawn); }
+            if (scene == PLAYING_SCENE){
+                const EntityStore &bullets = snapshot.bullets;
+                for (std::size_t i = 0; i < bullets.size(); ++i){
+                    effects.addTrail(bullets.clip[i], bullets.frame[i], bullets.x[i], bullets.y[i], bullets.angle[i], 0.1F, 96);
                 }
-                
-                //////////////////////////// @c CREATE-A-NEW-WAVE /////////////////////////
-                
-                
-                // create asteroid objects randomly based on wave format
-                if (gameObjs.size() == 1){ // when only one obj is left which is spaceship
-                    waveLength += 5;       // increase the wave length whenever player clears a wave successfully
-                    waveNo++;              // track the wave no.
-                    
-                    // draw the background so that the window can be cleared.
-                    window.clear();  window.draw(background[ith_background]);
-                    gameMessage("gameWave", waveNo, window);
-                    
-                    for (short int i = 0; i < waveLength; ++i){
-                        std::shared_ptr<GameObject> bigAsteroidObj = std::make_shared<Asteroid>();
-                        bigAsteroidObj->settings(bigAsteroidAnim, randNo(randGen) % imgBack.getSize().x, 
-                                                randNo(randGen) % imgBack.getSize().y, randNo(randGen) % 360, 20);
-                        gameObjs.push_back(bigAsteroidObj);
-                    }
+                if (snapshot.boosting  and  snapshot.ship.size() > 0){
+                    float behind = snapshot.ship.angle[0] * DEG_TO_RAD;
+                    effects.addTrail(EXPLOSION_CLIP_1, 0, shipX - std::cos(behind) * 30.0F, shipY - std::sin(behind) * 30.0F,
+                                     snapshot.ship.angle[0], 0.2F, 128);
                 }
+                effects.update(frameSeconds);
             }
             
             //////////////////////////// @c WINDOW-DRAW /////////////////////////
             
             
-            window.clear(); 
-            window.draw(background[ith_background]); // draw the the chosen background
-            if (inHomePage){ gameMessage("gameHomePage", 0, window); }
-            else { 
-                for (auto &obj : gameObjs){ obj->draw(window); }            // draw game objs
-                gameMessage("gameScore", playerScore, window);              // draw score
+            frameTimer.next(DRAW_PHASE);
+            window.clear();
+            background.setTexture(textures.get(BACKGROUND_FILES[ith_background], true));
+            window.draw(background); // draw the the chosen background
+            if (scene == HOME_SCENE  and  message.seconds > 0.0F){ gameMessage(message.id, message.number, window, message.text); }
+            else if (scene == HOME_SCENE){ for (Text &txt : homePageTexts){ window.draw(txt); } }
+            else if (scene == WAVE_BANNER_SCENE){ gameMessage(WAVE_MESSAGE, waveNo, window); }
+            else if (scene == GAME_OVER_SCENE){ // "HIGH SCORE !" for the last 2 seconds, if it was one
+                gameMessage((highScoreBeaten  and  sceneSeconds <= 2.0F)? HIGH_SCORE_MESSAGE : GAME_OVER_MESSAGE, 0, window);
+            }
+            else { // playing or paused
+                // draw game objs (batched per atlas page, the explosions on top of the rest)
+                sprites.clear();
+                for (const EntityStore *store : {&snapshot.ship, &snapshot.asteroids, &snapshot.bullets}){
+                    for (std::size_t i = 0; i < store->size(); ++i){
+                        animations[store->clip[i]].draw(*store, i, sprites, OBJECTS_LAYER, alpha);
+                    }
+                }
+                for (std::size_t i = 0; i < effects.size(); ++i){
+                    animations[effects.clip[i]].draw(effects, i, sprites, EFFECTS_LAYER);
+                }
+                window.setView(camera);  sprites.draw(window);  window.setView(window.getDefaultView());
+                gameMessage(SCORE_MESSAGE, snapshot.playerScore, window);       // draw score
                 
-                for (short int i = 0; i < playerHealthCount; ++i){             // draw health
+                for (short int i = 0; i < snapshot.playerHealth; ++i){         // draw health
                     playerHealth.setPosition(1050 + i*imgHealth.getSize().x, 20);
                     window.draw(playerHealth);
                 }
-                if (holdFire){                                                 // draw hold fire msz if recharging
-                    short int rechargingCounter = static_cast<int>(fireHoldClock.getElapsedTime().asSeconds());
-                    gameMessage("gameFireRecharge", (9 - rechargingCounter), window);
+                if (snapshot.fireOnHold){                                      // draw hold fire msz if recharging
+                    short int rechargingCounter = static_cast<int>(snapshot.fireHoldSeconds);
+                    gameMessage(FIRE_RECHARGE_MESSAGE, (9 - rechargingCounter), window);
+                }
+                if (showProfile){
+                    // rebuilt twice a second, the numbers are averages of the last frames anyway
+                    if (profiler.getFrameNo() % 60 == 0){ updateProfileOverlay(profileOverlay, profiler, snapshot, effects, sprites, mixer, textures); }
+                    window.draw(profileOverlay);
                 }
             }
+            frameTimer.stop(); // (the display waits for the frame limit, not timed)
             window.display();
+            profiler.endFrame();
+        }
+        sim.stop();
+        sim.getWorld().printStoreReport();
+        textures.printReport();
+        profiler.printAllocReport();
+    }
+    
+    
+    // the profile overlay : average ms of every phase, objects by kind, the sprite draw calls, the sound voices
+    // and the texture memory
+    void updateProfileOverlay(sf::Text &overlay, const Profiler &profiler, const RenderSnapshot &snapshot,
+                              const EffectSystem &effects, const SpriteBatch &sprites, const AudioMixer &mixer,
+                              const TextureManager &textures){
+        char line[128];
+        std::string text;
+        for (short int p = 0; p < PHASE_COUNT; ++p){
+            std::snprintf(line, sizeof(line), "%-11s %6.3f ms\n", PHASE_NAMES[p], profiler.averageMs(static_cast<ProfilePhase>(p)));
+            text += line;
+        }
+        std::snprintf(line, sizeof(line), "%-11s %6.3f ms\n\n", "frame", profiler.averageFrameMs());  text += line;
+        std::snprintf(line, sizeof(line), "bullets %zu  asteroids %zu  dormant %zu  effects %zu (peak %zu, dropped trails %lu)\n",
+                      snapshot.bullets.size(), snapshot.asteroids.size(), snapshot.dormantAsteroids, effects.size(),
+                      effects.getPeak(), effects.getDroppedTrails());  text += line;
+        std::snprintf(line, sizeof(line), "sprites %u  draw calls %u\n", sprites.getSpriteCount(), sprites.getDrawCalls());
+        text += line;
+        std::snprintf(line, sizeof(line), "voices %zu  sounds played %lu  stolen %lu  dropped %lu\n", mixer.getVoiceCount(),
+                      mixer.getPlayed(), mixer.getStolen(), mixer.getDropped());
+        text += line;
+        std::snprintf(line, sizeof(line), "textures %.1f / %.1f MB  evictions %u", textures.getGpuBytes() / 1048576.0,
+                      textures.getBudget() / 1048576.0, textures.getEvictions());
+        text += line;
+        if (AllocTracker::ENABLED){ // (built with ASTEROID_TRACK_ALLOCS)
+            float allocations = 0.0F;
+            for (short int p = 0; p <= PHASE_COUNT; ++p){ allocations += profiler.averageAllocs(p); }
+            std::snprintf(line, sizeof(line), "\nheap allocations %.1f per frame (%.0f bytes, draw %.1f, other %.1f)", allocations,
+                          profiler.averageAllocBytes(), profiler.averageAllocs(DRAW_PHASE), profiler.averageAllocs(OTHER_ALLOCS));
+            text += line;
         }
+        overlay.setString(text);
+    }
+    
+    
+    // the texts drawn every frame are built only once, the numbers are updated by NumberText::show()
+    void setupTexts(){
+        using namespace sf;
         
+        Font &f1 = resources.getFont(ALGERIAN_FONT), &f2 = resources.getFont(CAMBRIA_FONT);
+        scoreText.setup       (" Score : ",                   f1, 30, Color::Cyan, 1080, 50);
+        fireRechargeText.setup("Special Fire Recharging... ", f2, 20, Color::Cyan,   10, 10);
+        waveText.setup        (" Wave : ",                    f1, 60, Color::Cyan, screenSize.x / 2 - 125, screenSize.y / 2 - 45);
+        
+        homePageTexts[0] = Text(" NEW GAME \n",      f1);
+        homePageTexts[1] = Text("SCORE BOARD",       f1);
+        homePageTexts[2] = Text("Change Background", f2);
+        for (Text &txt : homePageTexts){ txt.setFillColor(Color::Cyan); }
+        homePageTexts[0].setPosition(screenSize.x / 2 - 90,                screenSize.y / 2 - 60);
+        homePageTexts[1].setPosition(screenSize.x / 2 - 95,                screenSize.y / 2 -  0);
+        homePageTexts[2].setPosition(screenSize.x / 2 - 125/*155 for f1*/, screenSize.y / 2 + 60);
     }
     
     
-    void loadInitialImage(sf::Texture &image, sf::RenderWindow &window){
+    // the splash screen : fades the startup image in while the assets load, the events are still
+    // pumped so the window can be closed (then it returns false)
+    bool loadInitialImage(const sf::Texture &image, sf::RenderWindow &window, AssetManager &assets){
         
         sf::Sprite startupImage(image);
         startupImage.setPosition(0, 0);
@@ -536,12 +498,15 @@ namespace Asteroid {
         float transparency = 0.0F; // range (0 - 255)
         
         while (true){
+            while (window.pollEvent(e)){
+                if (e.type == sf::Event::Closed){ window.close();  return false; }
+            }
             // update the transparency
             float dt = c.restart().asSeconds();
             if (transparency < 270.0F){ 
                 transparency += 75.0F * dt;
                 // means image loaded successfully and return to main pg.
-                if (transparency > 270.0F){ return; }
+                if (transparency > 270.0F){ return true; }
             }
             // set this transparency to the image sprite
             sf::Color startupImageColor = startupImage.getColor();
@@ -554,18 +519,74 @@ namespace Asteroid {
             window.clear();
             window.draw(startupImage);
             window.display();
+            assets.update(); // meanwhile create the textures which are already decoded
         }
     }
     
     
-    void gameMessage(sf::String &&m, short int mszDuration, sf::RenderWindow &window){
+    // the hover colors of the home page texts, and what the player chose in this frame
+    // (a click or the enter key, both events, so a held button doesn't choose again every frame)
+    HomeChoice homePage(sf::RenderWindow &window, bool clicked, bool enterPressed){
         using namespace sf;
         
-        Text txt;  Font f1,f2;
-        f1.loadFromFile("Fonts/algerian-regular.ttf");
-        f2.loadFromFile("Fonts/cambria-math.ttf");
+        Text &txt1 = homePageTexts[0], &txt2 = homePageTexts[1], &txt3 = homePageTexts[2];
+        for (Text &txt : homePageTexts){ txt.setFillColor(Color::Cyan); } // the prebuilt texts keep the last color
+        
+        // LOGIC FOR MOUSE HOVERING AND TAPPING
+        // get the positions of mouse and texts
+        Vector2i mousePosInWindow = Mouse::getPosition(window);
+        Vector2f mousePos = window.mapPixelToCoords(mousePosInWindow);
+        FloatRect txt1Pos = txt1.getGlobalBounds();
+        FloatRect txt2Pos = txt2.getGlobalBounds();
+        FloatRect txt3Pos = txt3.getGlobalBounds();
+        
+        if (txt1Pos.contains(mousePos)){       // checks that if the mouse cursor pos is on the text
+            txt1.setFillColor(Color::Magenta); // on hover color change
+            // by doing this the game will move from the home page to the playing page
+            if (clicked){ return NEW_GAME_CHOICE; }
+        }
+        else if (txt2Pos.contains(mousePos)){
+            txt2.setFillColor(Color::Magenta);
+            // by doing this the score board will be shown
+            if (clicked){ return SCORE_BOARD_CHOICE; }
+        }
+        else if (txt3Pos.contains(mousePos)){
+            txt3.setFillColor(Color::Magenta);
+            // by doing this background picture will be switched between different themes
+            if (clicked){ return BACKGROUND_CHOICE; }
+        }
+        // also the game starts based on the enter key pressed
+        return (enterPressed)? NEW_GAME_CHOICE : NO_CHOICE;
+    }
+    
+    
+    // the last and the high score, and the best 5 of the leaderboard with their dates
+    sf::String scoreBoardMessage(){
+        sf::String message= " Last Score : " + std::to_string(scores.getLastScore())
+                            + "\n\n" +
+                            " High Score : " + std::to_string(scores.getHighScore()) + "\n";
+        short int rank = 0;
+        for (const ScoreEntry &entry : scores.getLeaderboard()){
+            if (++rank > 5){ break; }
+            char line[64], date[16] = "-";
+            std::time_t playedAt = static_cast<std::time_t>(entry.time);
+            if (entry.time != 0){ std::strftime(date, sizeof(date), "%Y-%m-%d", std::localtime(&playedAt)); }
+            std::snprintf(line, sizeof(line), "\n %d.  %5d   %s", rank, entry.score, date);
+            message += line;
+        }
+        return message;
+    }
+
+
+    // draws a message (or a HUD text) of this frame, "number" is the score, the wave or the seconds shown in it
+    // (an id, not a string name : nothing is built on the heap just to pick the message every frame)
+    void gameMessage(MessageId id, short int number, sf::RenderWindow &window, const sf::String &m){
+        using namespace sf;
+        
+        Text txt;
+        Font &f1 = resources.getFont(ALGERIAN_FONT), &f2 = resources.getFont(CAMBRIA_FONT);
         
-        if (m == "gameInstructions"){
+        if (id == INSTRUCTIONS_MESSAGE){
             txt.setString("\
                 \n\n\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t Instructions .....\n\
                 \n\n\t\t\t\t\t\t\t\t\t\t\t(These are one time instructions so read it carefully)\
@@ -582,149 +603,75 @@ namespace Asteroid {
             txt.setFont(f2);  
             window.clear();
         }
-        else if (m == "gameHomePage"){
-            Text txt1(" NEW GAME \n",      f1);
-            Text txt2("SCORE BOARD",       f1);
-            Text txt3("Change Background", f2);
-            
-            txt1.setFillColor(Color::Cyan);
-            txt2.setFillColor(Color::Cyan);
-            txt3.setFillColor(Color::Cyan);
-            txt1.setPosition(imgBack.getSize().x / 2 - 90,                imgBack.getSize().y / 2 - 60);
-            txt2.setPosition(imgBack.getSize().x / 2 - 95,                imgBack.getSize().y / 2 -  0);
-            txt3.setPosition(imgBack.getSize().x / 2 - 125/*155 for f1*/, imgBack.getSize().y / 2 + 60);
-            
-            // LOGIC FOR MOUSE HOVERING AND TAPPING
-            // get the positions of mouse and texts
-            Vector2i mousePosInWindow = Mouse::getPosition(window);
-            Vector2f mousePos = window.mapPixelToCoords(mousePosInWindow);
-            FloatRect txt1Pos = txt1.getGlobalBounds();
-            FloatRect txt2Pos = txt2.getGlobalBounds();
-            FloatRect txt3Pos = txt3.getGlobalBounds();
-            
-            if (txt1Pos.contains(mousePos)){       // checks that if the mouse cursor pos is on the text
-                txt1.setFillColor(Color::Magenta); // on hover color change
-                // by doing this the game will move from the home page to the playing page
-                if (Mouse::isButtonPressed(Mouse::Left)){ inHomePage = false; }
-            }
-            else if (txt2Pos.contains(mousePos)){
-                txt2.setFillColor(Color::Magenta);
-                // by doing this the score board will be shown
-                if (Mouse::isButtonPressed(Mouse::Left)){
-                    String message= " Last Score : " + getGameScore("CurrentScore")
-                                    + "\n\n" + 
-                                    " High Score : " + getGameScore("HighestScore");
-                    gameMessage(std::move(message), 3, window);
-                }
-            }
-            else if (txt3Pos.contains(mousePos)){
-                txt3.setFillColor(Color::Magenta);
-                // by doing this background picture will be switched between different themes
-                if (Mouse::isButtonPressed(Mouse::Left)){ 
-                    ++ith_background;  if (ith_background >= 4){ ith_background = 0; }  
-                    sleep(seconds(0.3)); // sleep for small amount of time to take effects for changes
-                }
-            }
-            else { // return to previous color when mouse cursor is not hovered
-                txt1.setFillColor (Color::Cyan);
-                txt2.setFillColor(Color::Cyan);
-                txt3.setFillColor(Color::Cyan);
-                // also the game starts based on the enter key pressed
-                if (Keyboard::isKeyPressed(Keyboard::Return)){ inHomePage = false; }
-            }
-            // ----- draw the home page texts -----
-            window.draw(txt1);  window.draw(txt2);  window.draw(txt3);
-            return;
-        }
-        else if (m == "gameOver"){ 
+        else if (id == GAME_OVER_MESSAGE){ 
             txt.setString("GAME OVER !"); 
             txt.setFont(f1);
             txt.setFillColor(Color::Red);
-            txt.setPosition(imgBack.getSize().x / 2 - 80, imgBack.getSize().y / 2 - 45);
+            txt.setPosition(screenSize.x / 2 - 80, screenSize.y / 2 - 45);
             window.clear();
         }
-        else if (m == "gameHighScore"){ 
+        else if (id == HIGH_SCORE_MESSAGE){ 
             txt.setString("HIGH SCORE !"); 
             txt.setFont(f1);
             txt.setFillColor(Color::Green);
-            txt.setPosition(imgBack.getSize().x / 2 - 80, imgBack.getSize().y / 2 - 45);
+            txt.setPosition(screenSize.x / 2 - 80, screenSize.y / 2 - 45);
             window.clear();
         }
-        else if (m == "gameScore"){
-            txt.setString(" Score : " + std::to_string(mszDuration));
-            txt.setFont(f1);
-            txt.setPosition(1080, 50);
-            txt.setFillColor(Color::Cyan);
-            window.draw(txt);
+        else if (id == SCORE_MESSAGE){
+            window.draw(scoreText.show(number));
             return;
         }
-        else if (m == "gameWave"){
-            txt.setString(" Wave : " + std::to_string(mszDuration));
-            txt.setFont(f1);
-            txt.setCharacterSize(60);
-            txt.setFillColor(Color::Cyan);
-            txt.setPosition(imgBack.getSize().x / 2 - 125, imgBack.getSize().y / 2 - 45);
-            mszDuration = 2;
+        else if (id == WAVE_MESSAGE){
+            window.draw(waveText.show(number));
+            return;
         }
-        else if (m == "gameFireRecharge"){
-            txt.setString("Special Fire Recharging... " + std::to_string(mszDuration));
-            txt.setFont(f2);
-            txt.setPosition(10, 10);
-            txt.setCharacterSize(20);
-            txt.setFillColor(Color::Cyan);
-            window.draw(txt);
+        else if (id == FIRE_RECHARGE_MESSAGE){
+            window.draw(fireRechargeText.show(number));
             return;
         }
         else { // for default strings
             txt.setString(m); 
             txt.setFillColor(Color::Yellow);
             txt.setFont(f2);
-            txt.setPosition(imgBack.getSize().x / 2 - 110, imgBack.getSize().y / 2 - 60);
+            txt.setPosition(screenSize.x / 2 - 110, screenSize.y / 2 - 60);
             window.clear();
         }
-        window.draw(txt);  window.display();
-        sleep(seconds(mszDuration)); // sleep to pause the pg. and display the message
-    }
-    
-    
-    // this func used to get the current or highest score of the player
-    std::string getGameScore(std::string &&scoreType){
-        
-        std::ifstream fileToRead("AsteroidScore.txt", std::ios::in);
-        if (not fileToRead){ return std::string("0"); } // if file opens fails then return 0 as score
-        
-        std::string curScore, highScore;  
-        std::getline(fileToRead, curScore);  // 1 Line: last played score
-        std::getline(fileToRead, highScore); // 2 Line: highest score
-        fileToRead.close();
-        
-        if (scoreType == "CurrentScore"){ return curScore; }
-        else if (scoreType == "HighestScore"){ return highScore;  }
-        else { return std::string("0"); }
-    }
-    // this func is used to set the current or highest score of the player
-    void setGameScores(std::string &&curScore, std::string &&highScore){
-        
-        std::ofstream fileToWrite("AsteroidScore.txt");
-        fileToWrite << std::string(curScore) <<"\n"<< std::string(highScore);
-        fileToWrite.close();
+        window.draw(txt); // (the main loop keeps it on the screen as long as the scene wants)
     }
 }
 
 
-main(){
-    try { 
-        Asteroid::Main(); 
-    }
-    catch (short int score){ // score catches correctly
-        unsigned short int highScore = std::stoi(Asteroid::getGameScore("HighestScore"));
-        // if current score is greater than the existing high score then, update both the scores
-        if (score >= highScore){ 
-            Asteroid::setGameScores(std::to_string(score), std::to_string(score)); 
+main(int argc, char *argv[]){
+    // "GAME --profile timings.csv" (or .json for a Chrome trace) writes the phase timings of every frame
+    // "GAME --sim-thread" runs the simulation pipelined on its own thread
+    // "GAME --texture-budget 16" keeps the textures in 16 MB (the pinned ones always stay)
+    // "GAME --seed 7" plays the games 7, 8, 9 ... (the same asteroids and spread every time)
+    // "GAME --world-screens 4" plays in a world of 4 x 4 screens (1 .. 8), the view follows the ship
+    for (int i = 1; i < argc; ++i){
+        if (std::string(argv[i]) == "--profile"  and  i + 1 < argc){ Asteroid::profileOutput = argv[i + 1]; }
+        if (std::string(argv[i]) == "--sim-thread"){ Asteroid::simOnThread = true; }
+        if (std::string(argv[i]) == "--seed"  and  i + 1 < argc){ Asteroid::gameSeed = std::strtoul(argv[i + 1], nullptr, 10); }
+        if (std::string(argv[i]) == "--texture-budget"  and  i + 1 < argc){
+            Asteroid::textureBudgetMB = std::strtoul(argv[i + 1], nullptr, 10);
         }
-        else { // otherwise only update the current score
-            Asteroid::setGameScores(std::to_string(score), std::to_string(highScore)); 
+        if (std::string(argv[i]) == "--world-screens"  and  i + 1 < argc){
+            Asteroid::worldScreens = std::min(std::max(std::atoi(argv[i + 1]), 1), 8);
         }
     }
+    // "GAME --pack-assets" writes all the images and sounds into one archive (loaded faster)
+    if (argc > 1  and  std::string(argv[1]) == "--pack-assets"){
+        std::vector<std::string> files;
+        for (const Asteroid::AssetFile &file : Asteroid::ASSET_FILES){ files.push_back(file.path); }
+        bool packed = Asteroid::AssetArchive::pack(Asteroid::ASSET_ARCHIVE, files);
+        std::printf("%s %s\n", Asteroid::ASSET_ARCHIVE, (packed)? "written" : "could not be written");
+        return (packed)? 0 : 1;
+    }
+    Asteroid::scores.load(Asteroid::SCORE_FILE); // the only time the score file is read
+    Asteroid::Main(); // returns when the window is closed, any number of games later
+    // the scores are saved in the background, wait for the last one
+    if (not Asteroid::scores.flush()){ std::printf("the scores could not be saved to %s\n", Asteroid::SCORE_FILE); }
+    // the fonts must have been read only once, however long the game was played
+    std::printf("font loads : %u, hud text rebuilds : %u\n", Asteroid::resources.getFontLoads(),
+                Asteroid::scoreText.getRebuilds() + Asteroid::fireRechargeText.getRebuilds() + Asteroid::waveText.getRebuilds());
     return 0;
 }
\ No newline at end of file
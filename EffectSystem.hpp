@@ -0,0 +1,105 @@
+
+#pragma once
+// the visual only effects (explosions, bullet and thruster trails) : kept apart from the game objects,
+// so they cost nothing in the collision or the gameplay update, in compact arrays which are aged by
+// the frame time in one tight loop and drawn in one batch, the simulation only tells where the
+// explosions start (World::lastEffects) and nothing goes from here back into the game
+
+#include <algorithm>
+#include <vector>
+#include "Simulation.hpp"
+
+
+namespace Asteroid {
+
+    class EffectSystem {
+
+        private :
+
+        std::size_t capacity, peak;
+        unsigned int growths;
+        unsigned long droppedTrails;
+        /*
+        capacity      : the arrays are reserved for that many effects, more explosions still fit (counted in growths)
+        droppedTrails : trails not added as their room was full (the last quarter is kept for the explosions)
+        peak          : most effects alive at once
+        */
+
+        public :
+
+        std::vector<float> x, y, angle, age, lifetime;
+        std::vector<short int> clip, frame;
+        std::vector<unsigned char> alpha;
+        /*
+        age, lifetime : seconds since the effect started, and when it ends
+        frame         : -1 plays the clip through once (explosions), otherwise that frame is shown still
+        alpha         : opacity at the start, a still frame (trail) fades out to 0 over its lifetime
+        */
+
+        explicit EffectSystem(std::size_t count = 4096) noexcept {
+            capacity = peak = 0;  growths = 0;  droppedTrails = 0;  reserve(count);
+        }
+
+        void reserve(std::size_t count){
+            for (auto *column : {&x, &y, &angle, &age, &lifetime}){ column->reserve(count); }
+            clip.reserve(count);  frame.reserve(count);  alpha.reserve(count);
+            capacity = std::max(capacity, count);
+        }
+
+        void add(short int effectClip, short int stillFrame, float X, float Y, float degree, float seconds, unsigned char opacity){
+            if (x.size() == capacity){ reserve(std::max<std::size_t>(256, 2 * capacity));  ++growths; }
+            x.push_back(X);  y.push_back(Y);  angle.push_back(degree);  age.push_back(0.0F);  lifetime.push_back(seconds);
+            clip.push_back(effectClip);  frame.push_back(stillFrame);  alpha.push_back(opacity);
+            peak = std::max(peak, x.size());
+        }
+        // an explosion plays its clip once (at the 1 degree the old explosion objects had)
+        void addExplosion(const EffectSpawn &spawn){
+            const AnimationClip &animation = CLIPS[spawn.clip];
+            add(spawn.clip, -1, spawn.x, spawn.y, 1.0F, animation.frameCount * animation.frameSeconds, 255);
+        }
+        // a trail is a still frame fading out where a moving obj just was, every bullet adds one per
+        // drawn frame, so a storm of them would outgrow any capacity : past 3/4 of it they are dropped
+        void addTrail(short int trailClip, short int trailFrame, float X, float Y, float degree, float seconds, unsigned char opacity){
+            if (x.size() >= capacity - capacity / 4){ ++droppedTrails;  return; }
+            add(trailClip, trailFrame, X, Y, degree, seconds, opacity);
+        }
+
+        // age every effect and drop the finished ones (the rest is moved down in order, in the same pass)
+        void update(float seconds){
+            std::size_t kept = 0, count = x.size();
+            for (std::size_t i = 0; i < count; ++i){
+                float newAge = age[i] + seconds;
+                if (newAge >= lifetime[i]){ continue; }
+                if (kept != i){
+                    x[kept] = x[i];  y[kept] = y[i];  angle[kept] = angle[i];  lifetime[kept] = lifetime[i];
+                    clip[kept] = clip[i];  frame[kept] = frame[i];  alpha[kept] = alpha[i];
+                }
+                age[kept] = newAge;
+                ++kept;
+            }
+            for (auto *column : {&x, &y, &angle, &age, &lifetime}){ column->resize(kept); }
+            clip.resize(kept);  frame.resize(kept);  alpha.resize(kept);
+        }
+        void clear(){
+            for (auto *column : {&x, &y, &angle, &age, &lifetime}){ column->clear(); }
+            clip.clear();  frame.clear();  alpha.clear();
+        }
+
+        // the frame of the clip and the opacity the i'th effect shows now
+        inline short int frameOf(std::size_t i) const {
+            if (frame[i] >= 0){ return frame[i]; }
+            const AnimationClip &animation = CLIPS[clip[i]];
+            return std::min<short int>(static_cast<short int>(age[i] / animation.frameSeconds), animation.frameCount - 1);
+        }
+        inline unsigned char alphaOf(std::size_t i) const {
+            if (frame[i] < 0){ return alpha[i]; }
+            return static_cast<unsigned char>(alpha[i] * (1.0F - age[i] / lifetime[i]));
+        }
+
+        inline std::size_t size() const { return x.size(); }
+        inline std::size_t getCapacity() const { return capacity; }
+        inline std::size_t getPeak() const { return peak; }
+        inline unsigned int getGrowths() const { return growths; }
+        inline unsigned long getDroppedTrails() const { return droppedTrails; }
+    };
+}
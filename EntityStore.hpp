@@ -0,0 +1,124 @@
+
+#pragma once
+// contiguous (struct of arrays) storage for one kind of game objects,
+// so the update and collision passes just walk plain float arrays instead of list nodes
+// a store works as a fixed capacity pool : adding and removing an object is O(1) and never
+// touches the heap until the store grows past its capacity (its high-water mark)
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+
+namespace Asteroid {
+
+    // life of a stored object, BROKEN is a dead big asteroid which still has to split into small ones
+    enum EntityState : unsigned char { DEAD, ALIVE, BROKEN };
+
+
+    ////////////////////////////////// @c ENTITY-STORE-CLASS //////////////////////////////////
+
+
+    class EntityStore {
+
+        private :
+
+        std::size_t capacity, peak;
+        unsigned int growths;
+        /*
+        capacity : objects the columns hold without allocating (set by reserve)
+        peak     : most objects ever stored at once
+        growths  : how many times an add had to grow the columns past the capacity
+        */
+
+        public :
+
+        std::vector<float> x, y, dx, dy, angle, R, frameTime, prevX, prevY, prevAngle;
+        std::vector<unsigned char> life, kind;
+        std::vector<short int> clip, frame;
+        /*
+        x , y        : current co-ordinates of the objects
+        dx , dy      : velocity of the objects (added to x, y every step)
+        angle        : a angle in which direction the object is moving
+        R            : collision radious
+        life         : EntityState of the object
+        kind         : what the object is (an EntityKind, its fixed traits are in the ARCHETYPES table)
+        clip, frame  : which (shared) animation clip the object shows and its current frame
+        frameTime    : seconds the current frame is shown for (frame and frameTime are the clip cursor)
+        prevX, prevY, prevAngle : the state before the last step (the renderer draws in between)
+        (the i'th object of the store is the i'th element of every column)
+        */
+
+        EntityStore() noexcept { capacity = peak = 0;  growths = 0; }
+
+        inline std::size_t size() const { return x.size(); }
+        inline bool empty() const { return x.empty(); }
+        inline std::size_t getCapacity() const { return capacity; }
+        inline std::size_t getPeak() const { return peak; }
+        inline unsigned int getGrowths() const { return growths; }
+
+        // allocate every column for the given number of objects (the pool's high-water mark)
+        void reserve(std::size_t count){
+            if (count <= capacity){ return; }
+            x.reserve(count);  y.reserve(count);  dx.reserve(count);  dy.reserve(count);
+            angle.reserve(count);  R.reserve(count);  life.reserve(count);  kind.reserve(count);
+            clip.reserve(count);  frame.reserve(count);  frameTime.reserve(count);
+            prevX.reserve(count);  prevY.reserve(count);  prevAngle.reserve(count);
+            capacity = count;
+        }
+
+        // add a new alive object (not moving) and return its index
+        std::size_t add(short int animClip, float X, float Y, float degree, float radious, unsigned char objKind = 0){
+            if (x.size() == capacity){ reserve(std::max<std::size_t>(16, 2 * capacity));  ++growths; } // over the mark
+            x.push_back(X);  y.push_back(Y);  dx.push_back(0.0F);  dy.push_back(0.0F);
+            angle.push_back(degree);  R.push_back(radious);  life.push_back(ALIVE);  kind.push_back(objKind);
+            clip.push_back(animClip);  frame.push_back(0);  frameTime.push_back(0.0F);
+            prevX.push_back(X);  prevY.push_back(Y);  prevAngle.push_back(degree);
+            peak = std::max(peak, x.size());
+            return x.size() - 1;
+        }
+
+        // remove the i'th object by moving the last object into its place (so the order is not kept)
+        void remove(std::size_t i){
+            std::size_t last = x.size() - 1;
+            if (i != last){
+                x[i] = x[last];  y[i] = y[last];  dx[i] = dx[last];  dy[i] = dy[last];
+                angle[i] = angle[last];  R[i] = R[last];  life[i] = life[last];  kind[i] = kind[last];
+                clip[i] = clip[last];  frame[i] = frame[last];  frameTime[i] = frameTime[last];
+                prevX[i] = prevX[last];  prevY[i] = prevY[last];  prevAngle[i] = prevAngle[last];
+            }
+            x.pop_back();  y.pop_back();  dx.pop_back();  dy.pop_back();
+            angle.pop_back();  R.pop_back();  life.pop_back();  kind.pop_back();  clip.pop_back();  frame.pop_back();  frameTime.pop_back();
+            prevX.pop_back();  prevY.pop_back();  prevAngle.pop_back();
+        }
+
+        // move the i'th object into another store (like remove, the last object takes its place here)
+        // and return its index there
+        std::size_t moveTo(std::size_t i, EntityStore &to){
+            std::size_t j = to.add(clip[i], x[i], y[i], angle[i], R[i], kind[i]);
+            to.dx[j] = dx[i];  to.dy[j] = dy[i];  to.life[j] = life[i];  to.frame[j] = frame[i];  to.frameTime[j] = frameTime[i];
+            remove(i);
+            return j;
+        }
+
+        // remember the current state as the previous one (before a step changes it)
+        void savePrevious(){
+            std::copy(x.begin(), x.end(), prevX.begin());  std::copy(y.begin(), y.end(), prevY.begin());
+            std::copy(angle.begin(), angle.end(), prevAngle.begin());
+        }
+
+        // copy only the columns the renderer reads (the render snapshots of the sim thread), a copy is
+        // as big as the pool it copies, so copying never allocates once the copy got that big
+        void copyDrawState(const EntityStore &from){
+            reserve(from.capacity);
+            x = from.x;  y = from.y;  angle = from.angle;  clip = from.clip;  frame = from.frame;
+            prevX = from.prevX;  prevY = from.prevY;  prevAngle = from.prevAngle;
+        }
+
+        void clear(){
+            x.clear();  y.clear();  dx.clear();  dy.clear();  angle.clear();
+            R.clear();  life.clear();  kind.clear();  clip.clear();  frame.clear();  frameTime.clear();
+            prevX.clear();  prevY.clear();  prevAngle.clear();
+        }
+    };
+}
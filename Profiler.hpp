@@ -0,0 +1,240 @@
+
+#pragma once
+// per-phase frame timings : scoped timers add the time of every phase of a frame into a ring buffer
+// of the last frames (shown by the overlay), and every frame can also be streamed into a CSV or a
+// Chrome trace file (chrome://tracing or ui.perfetto.dev) for offline analysis, built with
+// ASTEROID_TRACK_ALLOCS it also counts the heap allocations of every phase (see AllocTracker.hpp)
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "AllocTracker.hpp"
+
+
+namespace Asteroid {
+
+    // the phases of one frame, in the order they run
+    enum ProfilePhase : short int {
+        EVENTS_PHASE, FIRE_PHASE, SHIP_INPUT_PHASE, COLLISION_PHASE, SPAWN_PHASE, UPDATE_PHASE,
+        WAVE_PHASE, DRAW_PHASE, PHASE_COUNT
+    };
+    constexpr const char* PHASE_NAMES[PHASE_COUNT] = {
+        "events", "fire", "ship input", "collision", "spawn", "update", "wave", "draw"
+    };
+    constexpr short int OTHER_ALLOCS = PHASE_COUNT; // the allocations outside the phases (any thread)
+    static_assert(PHASE_COUNT < AllocTracker::SLOTS, "every phase needs an allocation slot");
+
+
+    ////////////////////////////////// @c PROFILER-CLASS //////////////////////////////////
+
+
+    class Profiler {
+
+        public :
+
+        using ProfileClock = std::chrono::steady_clock;
+        enum TraceFormat : short int { NO_TRACE, CSV_TRACE, CHROME_TRACE };
+        static constexpr std::size_t HISTORY = 240; // frames kept for the averages (2 seconds)
+
+        private :
+
+        struct FrameRecord {
+            std::array<float, PHASE_COUNT> startMs, ms;
+            std::array<std::uint32_t, PHASE_COUNT + 1> allocs, allocBytes;
+            float frameMs;
+        };
+        std::array<FrameRecord, HISTORY> history;
+        FrameRecord current;
+        std::array<double, PHASE_COUNT> totalMs;
+        std::array<AllocCount, PHASE_COUNT + 1> frameAllocStart, totalAllocs;
+        double totalFrameMs;
+        std::size_t frameNo;
+        ProfileClock::time_point startTime, frameStart;
+        std::ofstream trace;
+        TraceFormat format;
+        /*
+        history    : ring buffer, frame n is at history[n % HISTORY]
+        current    : the frame being timed, startMs is -1 for a phase not run yet
+        startTime  : when the profiler was created (the trace time stamps start from it)
+        totalMs    : sums of all the frames so far (the benchmarks divide them by the work done)
+        allocs     : heap allocations (and their bytes) of every phase in the frame, [OTHER_ALLOCS] = outside
+                     the phases, only counted with ASTEROID_TRACK_ALLOCS (frameAllocStart : the counts at
+                     beginFrame, totalAllocs : of all the frames so far)
+        */
+        static short int allocSlot(short int phase){ return (phase == OTHER_ALLOCS)? AllocTracker::OUTSIDE : phase; }
+        static float msBetween(ProfileClock::time_point from, ProfileClock::time_point to){
+            return std::chrono::duration<float, std::milli>(to - from).count();
+        }
+
+        void writeFrame(){
+            if (format == CSV_TRACE){
+                trace << frameNo << ',' << current.frameMs;
+                for (float ms : current.ms){ trace << ',' << ms; }
+                trace << '\n';
+            }
+            else if (format == CHROME_TRACE){ // complete ("X") events in micro seconds
+                double frameUs = std::chrono::duration<double, std::micro>(frameStart - startTime).count();
+                char event[192];
+                std::snprintf(event, sizeof(event), "%s{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f}",
+                              (frameNo == 0)? "" : ",\n", frameUs, current.frameMs * 1000.0);
+                trace << event;
+                for (short int p = 0; p < PHASE_COUNT; ++p){
+                    if (current.startMs[p] < 0.0F){ continue; }
+                    std::snprintf(event, sizeof(event), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f}",
+                                  PHASE_NAMES[p], frameUs + current.startMs[p] * 1000.0, current.ms[p] * 1000.0);
+                    trace << event;
+                }
+            }
+        }
+
+        public :
+
+        Profiler(){
+            format = NO_TRACE;  frameNo = 0;
+            startTime = frameStart = ProfileClock::now();
+            for (FrameRecord &frame : history){
+                frame.startMs.fill(-1.0F);  frame.ms.fill(0.0F);  frame.frameMs = 0.0F;
+                frame.allocs.fill(0);  frame.allocBytes.fill(0);
+            }
+            current = history[0];
+            totalMs.fill(0.0);  totalFrameMs = 0.0;
+        }
+        ~Profiler(){ if (format == CHROME_TRACE){ trace << "\n]\n"; } }
+        Profiler(const Profiler &) = delete;
+        Profiler& operator=(const Profiler &) = delete;
+
+        // stream every frame into the file : Chrome trace JSON for a ".json" path, otherwise CSV
+        bool openTrace(const std::string &path){
+            trace.open(path, std::ios::out | std::ios::trunc);
+            if (not trace){ format = NO_TRACE;  return false; }
+            bool json = (path.size() >= 5  and  path.compare(path.size() - 5, 5, ".json") == 0);
+            format = (json)? CHROME_TRACE : CSV_TRACE;
+            if (format == CSV_TRACE){
+                trace << "frame,frame_ms";
+                for (const char *name : PHASE_NAMES){ trace << ',' << name << "_ms"; }
+                trace << '\n';
+            }
+            else { trace << "[\n"; }
+            return true;
+        }
+
+        void beginFrame(){
+            current.startMs.fill(-1.0F);  current.ms.fill(0.0F);
+            if (AllocTracker::ENABLED){
+                for (short int p = 0; p <= PHASE_COUNT; ++p){ frameAllocStart[p] = AllocTracker::total(allocSlot(p)); }
+            }
+            frameStart = ProfileClock::now();
+        }
+        // add a timed part of a phase (a phase may be timed more than once in a frame)
+        void record(ProfilePhase phase, ProfileClock::time_point from, ProfileClock::time_point to){
+            if (current.startMs[phase] < 0.0F){ current.startMs[phase] = msBetween(frameStart, from); }
+            current.ms[phase] += msBetween(from, to);
+        }
+        void endFrame(){
+            current.frameMs = msBetween(frameStart, ProfileClock::now());
+            if (AllocTracker::ENABLED){
+                for (short int p = 0; p <= PHASE_COUNT; ++p){
+                    AllocCount now = AllocTracker::total(allocSlot(p));
+                    current.allocs[p] = static_cast<std::uint32_t>(now.allocations - frameAllocStart[p].allocations);
+                    current.allocBytes[p] = static_cast<std::uint32_t>(now.bytes - frameAllocStart[p].bytes);
+                    totalAllocs[p].allocations += current.allocs[p];  totalAllocs[p].bytes += current.allocBytes[p];
+                }
+            }
+            history[frameNo % HISTORY] = current;
+            for (short int p = 0; p < PHASE_COUNT; ++p){ totalMs[p] += current.ms[p]; }
+            totalFrameMs += current.frameMs;
+            writeFrame();
+            ++frameNo;
+        }
+
+        // averages over the frames in the ring buffer
+        float averageMs(ProfilePhase phase) const {
+            std::size_t frames = std::min(frameNo, HISTORY);
+            float total = 0.0F;
+            for (std::size_t f = 0; f < frames; ++f){ total += history[f].ms[phase]; }
+            return (frames == 0)? 0.0F : total / frames;
+        }
+        float averageFrameMs() const {
+            std::size_t frames = std::min(frameNo, HISTORY);
+            float total = 0.0F;
+            for (std::size_t f = 0; f < frames; ++f){ total += history[f].frameMs; }
+            return (frames == 0)? 0.0F : total / frames;
+        }
+        // allocations per frame of a phase (or OTHER_ALLOCS), and bytes per frame of them all
+        float averageAllocs(short int phase) const {
+            std::size_t frames = std::min(frameNo, HISTORY);
+            float total = 0.0F;
+            for (std::size_t f = 0; f < frames; ++f){ total += history[f].allocs[phase]; }
+            return (frames == 0)? 0.0F : total / frames;
+        }
+        float averageAllocBytes() const {
+            std::size_t frames = std::min(frameNo, HISTORY);
+            float total = 0.0F;
+            for (std::size_t f = 0; f < frames; ++f){
+                for (std::uint32_t phaseBytes : history[f].allocBytes){ total += phaseBytes; }
+            }
+            return (frames == 0)? 0.0F : total / frames;
+        }
+        // the allocations of every phase per frame, over all the frames so far
+        void printAllocReport() const {
+            if (not AllocTracker::ENABLED){ return; }
+            double frames = std::max<double>(frameNo, 1.0);
+            std::printf("heap allocations per frame over %zu frames :\n", frameNo);
+            for (short int p = 0; p <= PHASE_COUNT; ++p){
+                std::printf("  %-11s %9.2f allocations %11.1f bytes\n", (p == OTHER_ALLOCS)? "other" : PHASE_NAMES[p],
+                            totalAllocs[p].allocations / frames, totalAllocs[p].bytes / frames);
+            }
+        }
+
+        inline double getTotalMs(ProfilePhase phase) const { return totalMs[phase]; }
+        inline const AllocCount& getTotalAllocs(short int phase) const { return totalAllocs[phase]; }
+        inline double getTotalFrameMs() const { return totalFrameMs; }
+        inline std::size_t getFrameNo() const { return frameNo; }
+        inline TraceFormat getTraceFormat() const { return format; }
+    };
+
+
+    ////////////////////////////////// @c PROFILE-SCOPE-CLASS //////////////////////////////////
+
+
+    // times its own life as a part of a phase (does nothing without a profiler),
+    // next() ends the current phase and starts timing the following one, stop() just ends it
+    class ProfileScope {
+
+        private :
+
+        Profiler *profiler;
+        ProfilePhase phase;
+        short int outerPhase; // the allocations go back to it when this scope ends
+        bool running;
+        Profiler::ProfileClock::time_point start;
+
+        public :
+
+        ProfileScope(Profiler *frameProfiler, ProfilePhase timedPhase) noexcept {
+            profiler = frameProfiler;  phase = timedPhase;  running = (profiler != nullptr);
+            outerPhase = AllocTracker::current();
+            if (running){ AllocTracker::enter(phase);  start = Profiler::ProfileClock::now(); }
+        }
+        ~ProfileScope(){ stop(); }
+        ProfileScope(const ProfileScope &) = delete;
+        ProfileScope& operator=(const ProfileScope &) = delete;
+
+        void stop(){
+            if (running){
+                profiler->record(phase, start, Profiler::ProfileClock::now());  running = false;
+                AllocTracker::enter(outerPhase);
+            }
+        }
+        void next(ProfilePhase nextPhase){
+            if (profiler == nullptr){ return; }
+            auto now = Profiler::ProfileClock::now();
+            if (running){ profiler->record(phase, start, now); }
+            phase = nextPhase;  start = now;  running = true;
+            AllocTracker::enter(phase);
+        }
+    };
+}
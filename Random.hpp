@@ -0,0 +1,86 @@
+
+#pragma once
+// small and fast random numbers : xoshiro128** (4 x 32 bit state, a few shifts and xors per number,
+// no division), seeded through splitmix64, so every seed and stream gives an unrelated sequence
+// - each subsystem draws from a stream of its own (spawning, weapon spread, effects), so more
+//   effects on the screen never change where the next asteroid spawns
+// - a range is mapped with one multiply (Lemire's method, the bias is below n / 2^32), not a modulo
+// - fill() writes a whole buffer at once, for a batched pass which then runs in parallel
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Asteroid {
+
+    enum RandomStream : short int { SPAWN_STREAM, WEAPON_STREAM, EFFECT_STREAM, STREAM_COUNT };
+
+
+    ////////////////////////////////// @c XOSHIRO-GENERATOR //////////////////////////////////
+
+
+    class Random {
+
+        private :
+
+        std::array<std::uint32_t, 4> state;
+
+        static inline std::uint32_t rotate(std::uint32_t x, int k){ return (x << k) | (x >> (32 - k)); }
+        static inline std::uint64_t splitMix(std::uint64_t &x){
+            std::uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        public :
+
+        explicit Random(std::uint32_t seedNo = 1, short int stream = 0) noexcept { seed(seedNo, stream); }
+
+        // the same seed and stream always give the same sequence
+        void seed(std::uint32_t seedNo, short int stream = 0){
+            std::uint64_t x = (static_cast<std::uint64_t>(stream) << 32) | seedNo;
+            std::uint64_t a = splitMix(x), b = splitMix(x); // never all zero
+            state = { static_cast<std::uint32_t>(a), static_cast<std::uint32_t>(a >> 32),
+                      static_cast<std::uint32_t>(b), static_cast<std::uint32_t>(b >> 32) };
+        }
+
+        inline std::uint32_t next(){
+            std::uint32_t result = rotate(state[1] * 5, 7) * 9, t = state[1] << 9;
+            state[2] ^= state[0];  state[3] ^= state[1];  state[1] ^= state[2];  state[0] ^= state[3];
+            state[2] ^= t;         state[3] = rotate(state[3], 11);
+            return result;
+        }
+        // 0 .. n-1
+        inline std::uint32_t below(std::uint32_t n){ return static_cast<std::uint32_t>((static_cast<std::uint64_t>(next()) * n) >> 32); }
+        // low .. high (both included)
+        inline int range(int low, int high){ return low + static_cast<int>(below(static_cast<std::uint32_t>(high - low + 1))); }
+        // 0 .. 1 (1 not included)
+        inline float uniform(){ return (next() >> 8) * (1.0F / 16777216.0F); }
+
+        // count numbers of low .. high into out (e.g. the spread of every bullet of a step)
+        template<class Number> void fill(Number *out, std::size_t count, int low, int high){
+            std::uint32_t n = static_cast<std::uint32_t>(high - low + 1);
+            for (std::size_t i = 0; i < count; ++i){ out[i] = static_cast<Number>(low + static_cast<int>(below(n))); }
+        }
+    };
+
+
+    // one generator per stream, all from one seed
+    class RandomStreams {
+
+        private :
+
+        std::array<Random, STREAM_COUNT> streams;
+
+        public :
+
+        explicit RandomStreams(std::uint32_t seedNo = 1) noexcept { seed(seedNo); }
+
+        void seed(std::uint32_t seedNo){
+            for (short int s = 0; s < STREAM_COUNT; ++s){ streams[s].seed(seedNo, s); }
+        }
+        inline Random& operator[](RandomStream stream){ return streams[stream]; }
+    };
+}
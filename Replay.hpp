@@ -0,0 +1,189 @@
+
+#pragma once
+// a compact binary log of the inputs of every simulation step, so a played game can be stepped
+// again without a window (Benchmark --replay) : same seed + same inputs = the same game
+// layout : "ASTREP02", seed (u32), world width and height, active range x and y, wave scale (u16 each,
+//          see World::setActiveRange, a "ASTREP01" log stops after the height), then runs of steps with the
+//          same input : flags (u8 : special fire, left, right, up, presses follow), if presses follow
+//          single fires and fire type changes (u8 each, only for the first step of the run), then
+//          the step count of the run (LEB128 varint), and at the end 0xFF, the step count (u32)
+//          and World::stateHash() (u64) after the last step (numbers in the byte order of the machine)
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "Simulation.hpp"
+
+
+namespace Asteroid {
+
+    constexpr char REPLAY_MAGIC[8] = { 'A', 'S', 'T', 'R', 'E', 'P', '0', '2' };
+    constexpr std::size_t REPLAY_VERSION_AT = 7; // the last magic char, '1' = the logs before large worlds
+    constexpr unsigned char REPLAY_END = 0xFF;
+
+    enum ReplayFlag : unsigned char {
+        SPECIAL_FIRE_FLAG = 1, LEFT_FLAG = 2, RIGHT_FLAG = 4, UP_FLAG = 8, PRESSES_FLAG = 16
+    };
+
+
+    ////////////////////////////////// @c INPUT-RECORDER-CLASS //////////////////////////////////
+
+
+    class InputRecorder {
+
+        private :
+
+        std::ofstream out;
+        FrameInput run;
+        std::uint32_t runSteps, totalSteps;
+        /*
+        run      : input of the run being collected (its presses only happened in its first step)
+        runSteps : how many steps the run has so far
+        */
+        static unsigned char heldFlags(const FrameInput &input){
+            return (input.specialFire? SPECIAL_FIRE_FLAG : 0) | (input.left? LEFT_FLAG : 0)
+                 | (input.right? RIGHT_FLAG : 0) | (input.up? UP_FLAG : 0);
+        }
+        template<class Number> void write(Number value){ out.write(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+        void writeRun(){
+            bool presses = (run.singleFires != 0  or  run.fireTypeChanges != 0);
+            write<unsigned char>(heldFlags(run) | (presses? PRESSES_FLAG : 0));
+            if (presses){
+                write<unsigned char>(std::min<short int>(run.singleFires, 255));
+                write<unsigned char>(std::min<short int>(run.fireTypeChanges, 255));
+            }
+            std::uint32_t steps = runSteps;
+            do { // 7 bits at a time, the high bit says more follow
+                write<unsigned char>((steps & 0x7F) | ((steps > 0x7F)? 0x80 : 0));
+                steps >>= 7;
+            } while (steps != 0);
+        }
+
+        public :
+
+        InputRecorder() noexcept { runSteps = totalSteps = 0; }
+
+        bool open(const std::string &path, const World &world){
+            out.open(path, std::ios::binary | std::ios::trunc);
+            if (not out){ return false; }
+            out.write(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+            write<std::uint32_t>(world.getSeed());
+            write<std::uint16_t>(world.getWidth());  write<std::uint16_t>(world.getHeight());
+            write<std::uint16_t>(world.getActiveRangeX());  write<std::uint16_t>(world.getActiveRangeY());
+            write<std::uint16_t>(world.getWaveScale());
+            runSteps = totalSteps = 0;
+            return true;
+        }
+        inline bool isOpen() const { return out.is_open(); }
+
+        // the input of the next step (call it before World::step)
+        void record(const FrameInput &input){
+            if (not out.is_open()){ return; }
+            bool presses = (input.singleFires != 0  or  input.fireTypeChanges != 0);
+            if (runSteps > 0  and  not presses  and  heldFlags(input) == heldFlags(run)){ ++runSteps; }
+            else {
+                if (runSteps > 0){ writeRun(); }
+                run = input;  runSteps = 1;
+            }
+            ++totalSteps;
+        }
+        // write the last run and the state the recorded steps ended in
+        void close(const World &world){
+            if (not out.is_open()){ return; }
+            if (runSteps > 0){ writeRun(); }
+            write<unsigned char>(REPLAY_END);
+            write<std::uint32_t>(totalSteps);  write<std::uint64_t>(world.stateHash());
+            out.close();
+        }
+    };
+
+
+    ////////////////////////////////// @c INPUT-REPLAY-CLASS //////////////////////////////////
+
+
+    class InputReplay {
+
+        private :
+
+        std::ifstream in;
+        FrameInput run;
+        std::uint32_t runLeft, endSteps;
+        std::uint64_t endHash;
+        unsigned int seed, width, height, rangeX, rangeY, waveScale;
+        bool ended;
+        /*
+        runLeft           : steps of the current run not given out yet
+        endSteps, endHash : the recorded step count and state hash (valid when ended)
+        */
+        template<class Number> bool read(Number &value){
+            return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+        }
+
+        public :
+
+        InputReplay() noexcept {
+            runLeft = endSteps = 0;  endHash = 0;  seed = width = height = rangeX = rangeY = 0;  waveScale = 1;  ended = false;
+        }
+
+        // false if the file is missing or not a replay
+        bool open(const std::string &path){
+            in.open(path, std::ios::binary);
+            char magic[sizeof(REPLAY_MAGIC)];
+            std::uint32_t fileSeed;  std::uint16_t fileWidth, fileHeight, fileRangeX = 0, fileRangeY = 0, fileScale = 1;
+            if (not in.read(magic, sizeof(magic))
+                or  std::string(magic, REPLAY_VERSION_AT) != std::string(REPLAY_MAGIC, REPLAY_VERSION_AT)
+                or  (magic[REPLAY_VERSION_AT] != '1'  and  magic[REPLAY_VERSION_AT] != REPLAY_MAGIC[REPLAY_VERSION_AT])){
+                return false;
+            }
+            if (not read(fileSeed)  or  not read(fileWidth)  or  not read(fileHeight)){ return false; }
+            if (magic[REPLAY_VERSION_AT] != '1'  and  (not read(fileRangeX)  or  not read(fileRangeY)  or  not read(fileScale))){
+                return false;
+            }
+            seed = fileSeed;  width = fileWidth;  height = fileHeight;
+            rangeX = fileRangeX;  rangeY = fileRangeY;  waveScale = fileScale;
+            runLeft = 0;  ended = false;
+            return true;
+        }
+
+        // the input of the next step, false at the end of the log (or a cut off file)
+        bool next(FrameInput &input){
+            if (runLeft == 0){
+                unsigned char flags, byte;
+                if (ended  or  not read(flags)){ return false; }
+                if (flags == REPLAY_END){
+                    ended = read(endSteps)  and  read(endHash);
+                    return false;
+                }
+                run = FrameInput();
+                run.specialFire = flags & SPECIAL_FIRE_FLAG;  run.left = flags & LEFT_FLAG;
+                run.right = flags & RIGHT_FLAG;               run.up = flags & UP_FLAG;
+                if (flags & PRESSES_FLAG){
+                    if (not read(byte)){ return false; }   run.singleFires = byte;
+                    if (not read(byte)){ return false; }   run.fireTypeChanges = byte;
+                }
+                short int shift = 0;
+                do {
+                    if (not read(byte)){ return false; }
+                    runLeft |= static_cast<std::uint32_t>(byte & 0x7F) << shift;  shift += 7;
+                } while (byte & 0x80);
+                if (runLeft == 0){ return false; }
+            }
+            input = run;
+            run.singleFires = run.fireTypeChanges = 0; // the presses only belong to the first step
+            --runLeft;
+            return true;
+        }
+
+        inline unsigned int getSeed() const { return seed; }
+        inline unsigned int getWidth() const { return width; }
+        inline unsigned int getHeight() const { return height; }
+        inline unsigned int getActiveRangeX() const { return rangeX; }
+        inline unsigned int getActiveRangeY() const { return rangeY; }
+        inline unsigned int getWaveScale() const { return waveScale; }
+        inline bool hasEnd() const { return ended; } // the log was closed properly (step count and hash known)
+        inline std::uint32_t getEndSteps() const { return endSteps; }
+        inline std::uint64_t getEndHash() const { return endHash; }
+    };
+}
@@ -0,0 +1,74 @@
+
+#pragma once
+// fonts are parsed once and kept (together with their glyph caches) for the whole game,
+// and the HUD texts are built once, their strings only change when the shown number changes
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <string>
+
+
+namespace Asteroid {
+
+    enum FontId : short int { ALGERIAN_FONT, CAMBRIA_FONT, FONT_COUNT };
+    constexpr const char* FONT_FILES[FONT_COUNT] = { "Fonts/algerian-regular.ttf", "Fonts/cambria-math.ttf" };
+
+
+    ////////////////////////////////// @c RESOURCE-CACHE-CLASS //////////////////////////////////
+
+
+    class ResourceCache {
+
+        private :
+
+        std::array<sf::Font, FONT_COUNT> fonts;
+        std::array<bool, FONT_COUNT> loaded;
+        unsigned int fontLoads;  // how many times a font file was read from the disk
+
+        public :
+
+        ResourceCache() noexcept { loaded.fill(false);  fontLoads = 0; }
+
+        // load the font on its first use, after that always return the same (already parsed) font
+        sf::Font& getFont(FontId id){
+            if (not loaded[id]){
+                fonts[id].loadFromFile(FONT_FILES[id]);
+                loaded[id] = true;  ++fontLoads;
+            }
+            return fonts[id];
+        }
+        inline unsigned int getFontLoads() const { return fontLoads; }
+    };
+
+
+    ////////////////////////////////// @c NUMBER-TEXT-CLASS //////////////////////////////////
+
+
+    class NumberText { // a prebuilt text like " Score : 12" whose string is only rebuilt when the number changes
+
+        private :
+
+        sf::Text text;
+        std::string label;
+        int shownValue;
+        bool shown;
+        unsigned int rebuilds; // how many times the string was built
+
+        public :
+
+        NumberText() noexcept { shownValue = 0;  shown = false;  rebuilds = 0; }
+
+        void setup(std::string &&textLabel, const sf::Font &font, unsigned int size, sf::Color color, float X, float Y){
+            label = std::move(textLabel);  shown = false;
+            text.setFont(font);  text.setCharacterSize(size);  text.setFillColor(color);  text.setPosition(X, Y);
+        }
+        const sf::Text& show(int value){
+            if (not shown  or  value != shownValue){
+                text.setString(label + std::to_string(value));
+                shownValue = value;  shown = true;  ++rebuilds;
+            }
+            return text;
+        }
+        inline unsigned int getRebuilds() const { return rebuilds; }
+    };
+}
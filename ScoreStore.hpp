@@ -0,0 +1,187 @@
+
+#pragma once
+// the scores live in memory : they are read from the file once at the start, and every change is
+// saved by a background thread (into a temp file, flushed to the disk, then renamed over the old
+// file, so a crash while saving leaves the old scores and never half a file)
+// file : the last score, the high score, then a "score time" line per leaderboard entry (best first)
+//        (the first two lines are all the older versions wrote, so their files still load)
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <io.h>
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+
+namespace Asteroid {
+
+    constexpr std::size_t TOP_SCORES = 10; // leaderboard entries kept
+
+    struct ScoreEntry {
+        short int score;
+        std::int64_t time; // when it was played (seconds since 1970, 0 if unknown)
+    };
+
+
+    class ScoreStore {
+
+        private :
+
+        std::string path;
+        short int lastScore, highScore;
+        std::vector<ScoreEntry> leaderboard;
+        std::thread writer;
+        std::mutex lock;
+        std::condition_variable changed, saved;
+        std::string pendingText;
+        bool dirty, writing, stopping, lastSaveOk;
+        unsigned int saves, failedSaves;
+        /*
+        lastScore, highScore, leaderboard : only used on the main thread
+        pendingText : the file contents the writer has to save next (a newer one replaces an unsaved one)
+        dirty       : pendingText is not saved yet,  writing : the writer is saving right now
+        */
+
+        std::string serialize() const {
+            std::string text = std::to_string(lastScore) + "\n" + std::to_string(highScore);
+            for (const ScoreEntry &entry : leaderboard){
+                text += "\n" + std::to_string(entry.score) + " " + std::to_string(entry.time);
+            }
+            return text;
+        }
+
+        // write into "path.tmp", flush it to the disk and rename it over "path"
+        static bool writeAtomically(const std::string &path, const std::string &text){
+            std::string temp = path + ".tmp";
+            std::FILE *file = std::fopen(temp.c_str(), "wb");
+            if (file == nullptr){ return false; }
+            bool ok = (std::fwrite(text.data(), 1, text.size(), file) == text.size())  and  std::fflush(file) == 0;
+        #if defined(_WIN32)
+            ok = ok  and  _commit(_fileno(file)) == 0;
+        #else
+            ok = ok  and  fsync(fileno(file)) == 0;
+        #endif
+            ok = (std::fclose(file) == 0)  and  ok;
+            if (not ok){ std::remove(temp.c_str());  return false; }
+
+        #if defined(_WIN32)
+            return MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+        #else
+            if (std::rename(temp.c_str(), path.c_str()) != 0){ return false; }
+            // and the directory, so the rename itself survives a power cut
+            std::size_t slash = path.find_last_of('/');
+            std::string folder = (slash == std::string::npos)? "." : path.substr(0, slash + 1);
+            int folderFile = open(folder.c_str(), O_RDONLY);
+            if (folderFile >= 0){ fsync(folderFile);  close(folderFile); }
+            return true;
+        #endif
+        }
+
+        void work(){
+            std::unique_lock<std::mutex> guard(lock);
+            while (true){
+                changed.wait(guard, [this]{ return dirty  or  stopping; });
+                if (not dirty){ return; } // stopping, and everything is saved
+                std::string text = std::move(pendingText);
+                dirty = false;  writing = true;
+                guard.unlock();
+                bool ok = writeAtomically(path, text);
+                guard.lock();
+                writing = false;  lastSaveOk = ok;
+                if (ok){ ++saves; } else { ++failedSaves; }
+                saved.notify_all();
+            }
+        }
+
+        public :
+
+        ScoreStore() noexcept {
+            lastScore = highScore = 0;
+            dirty = writing = stopping = false;  lastSaveOk = true;
+            saves = failedSaves = 0;
+        }
+        ~ScoreStore(){ // saves what is still pending
+            if (not writer.joinable()){ return; }
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            changed.notify_all();
+            writer.join();
+        }
+        ScoreStore(const ScoreStore &) = delete;
+        ScoreStore& operator=(const ScoreStore &) = delete;
+
+        // read the file (once, at the start), false if there is none yet (then all the scores are 0)
+        bool load(const std::string &filePath){
+            path = filePath;
+            if (not writer.joinable()){ writer = std::thread([this]{ work(); }); }
+            lastScore = highScore = 0;  leaderboard.clear();
+
+            std::ifstream file(path);
+            if (not file){ return false; }
+            std::string line;
+            if (std::getline(file, line)){ lastScore = static_cast<short int>(std::strtol(line.c_str(), nullptr, 10)); }
+            if (std::getline(file, line)){ highScore = static_cast<short int>(std::strtol(line.c_str(), nullptr, 10)); }
+            long long score, time;
+            while (std::getline(file, line)  and  leaderboard.size() < TOP_SCORES){
+                if (std::sscanf(line.c_str(), "%lld %lld", &score, &time) == 2){
+                    leaderboard.push_back({static_cast<short int>(score), static_cast<std::int64_t>(time)});
+                }
+            }
+            // an older file only has the high score, it starts the leaderboard (played at an unknown time)
+            if (leaderboard.empty()  and  highScore > 0){ leaderboard.push_back({highScore, 0}); }
+            return true;
+        }
+
+        // a finished game : updates the scores at once, the file is saved in the background
+        void submit(short int score){
+            lastScore = score;  highScore = std::max(highScore, score);
+            ScoreEntry entry = {score, static_cast<std::int64_t>(std::time(nullptr))};
+            auto at = std::upper_bound(leaderboard.begin(), leaderboard.end(), entry,
+                                       [](const ScoreEntry &a, const ScoreEntry &b){ return a.score > b.score; });
+            leaderboard.insert(at, entry); // after the older entries with the same score
+            if (leaderboard.size() > TOP_SCORES){ leaderboard.pop_back(); }
+            if (not writer.joinable()){ return; } // not loaded, so nowhere to save
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                pendingText = serialize();  dirty = true;
+            }
+            changed.notify_one();
+        }
+
+        // wait until everything submitted is saved, false if the last save failed
+        bool flush(){
+            if (not writer.joinable()){ return lastSaveOk; }
+            std::unique_lock<std::mutex> guard(lock);
+            saved.wait(guard, [this]{ return not dirty  and  not writing; });
+            return lastSaveOk;
+        }
+
+        inline short int getLastScore() const { return lastScore; }
+        inline short int getHighScore() const { return highScore; }
+        inline const std::vector<ScoreEntry>& getLeaderboard() const { return leaderboard; }
+        inline unsigned int getSaves() const { return saves; }             // read them after flush()
+        inline unsigned int getFailedSaves() const { return failedSaves; }
+    };
+}
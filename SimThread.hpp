@@ -0,0 +1,240 @@
+
+#pragma once
+// runs the World in fixed steps, either on the calling (main) thread or pipelined on a thread of
+// its own : then the sim steps frame N+1 while the main thread draws a snapshot of frame N
+// - the inputs go to the sim and the events (and explosions) come back through single producer /
+//   single consumer queues
+// - the snapshots are handed over through a lock free triple buffer (the sim always has a free one
+//   to write, and the renderer always reads the latest complete one, nobody waits for the other)
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Replay.hpp"
+#include "Simulation.hpp"
+
+
+namespace Asteroid {
+
+    constexpr short int MAX_STEPS_PER_FRAME = 8; // behind more than that, the game slows down instead of freezing
+
+
+    ////////////////////////////////// @c SPSC-QUEUE-CLASS //////////////////////////////////
+
+
+    // a fixed size ring, push() only from one thread and pop() only from one other thread
+    template<class Item, std::size_t CAPACITY> class SpscQueue {
+
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "the capacity must be a power of 2");
+
+        private :
+
+        std::array<Item, CAPACITY> items;
+        alignas(64) std::atomic<std::size_t> head; // next item to pop (only moved by the consumer)
+        alignas(64) std::atomic<std::size_t> tail; // next free slot (only moved by the producer)
+
+        public :
+
+        SpscQueue() noexcept : head(0), tail(0) {}
+
+        bool push(const Item &item){ // false if full
+            std::size_t at = tail.load(std::memory_order_relaxed);
+            if (at - head.load(std::memory_order_acquire) == CAPACITY){ return false; }
+            items[at & (CAPACITY - 1)] = item;
+            tail.store(at + 1, std::memory_order_release);
+            return true;
+        }
+        bool pop(Item &item){ // false if empty
+            std::size_t at = head.load(std::memory_order_relaxed);
+            if (at == tail.load(std::memory_order_acquire)){ return false; }
+            item = items[at & (CAPACITY - 1)];
+            head.store(at + 1, std::memory_order_release);
+            return true;
+        }
+    };
+
+
+    ////////////////////////////////// @c RENDER-SNAPSHOT //////////////////////////////////
+
+
+    struct RenderSnapshot { // everything the front end draws of one simulated moment
+        EntityStore ship, bullets, asteroids; // only the drawn columns (EntityStore::copyDrawState)
+        short int playerScore = 0, playerHealth = 0, waveNo = 0;
+        std::size_t dormantAsteroids = 0; // large worlds : the far asteroids not stepped right now
+        bool boosting = false, fireOnHold = false, gameOver = false;
+        float fireHoldSeconds = 0.0F;
+        std::chrono::steady_clock::time_point stepTime; // the real time the last step stands for (the
+                                                        // renderer interpolates from it, see SimThread::alphaOf)
+    };
+
+
+    ////////////////////////////////// @c SIM-THREAD-CLASS //////////////////////////////////
+
+
+    class SimThread {
+
+        private :
+
+        using SimClock = std::chrono::steady_clock;
+        static constexpr unsigned int FRESH = 4; // set on the middle index when it was not read yet
+
+        World world;
+        std::array<RenderSnapshot, 3> snapshots;
+        std::atomic<unsigned int> middle;
+        unsigned int back, front;
+        SpscQueue<FrameInput, 64> inputs;
+        SpscQueue<GameEvent, 1024> events;
+        SpscQueue<EffectSpawn, 4096> effects;
+        FrameInput pending;
+        InputRecorder recorder;
+        std::string replayPath;
+        SimClock::time_point lastTime, pausedAt;
+        float lag;
+        std::atomic<bool> running, paused, resumed;
+        bool threaded;
+        std::thread worker;
+        /*
+        back    : the snapshot the sim writes,  front : the snapshot the renderer reads
+        middle  : the last published one (exchanged by both sides, with the FRESH bit)
+        pending : inputs collected for the next step (key presses count for one step only)
+        effects : the explosions to play, when the front end falls that far behind the rest is not shown
+        recorder: logs the input of every step (if opened), closed with the final state by stop()
+        lag     : real seconds not simulated yet
+        pausedAt: main thread, when the pause started (the paused objects are drawn as they were then)
+        resumed : the time while paused must not be caught up
+        */
+
+        // copy the world into the back snapshot and swap it in as the latest one
+        void publish(){
+            RenderSnapshot &snapshot = snapshots[back];
+            snapshot.ship.copyDrawState(world.getShip());
+            snapshot.bullets.copyDrawState(world.getBullets());
+            snapshot.asteroids.copyDrawState(world.getAsteroids());
+            snapshot.playerScore = world.getPlayerScore();
+            snapshot.playerHealth = std::max<short int>(world.getPlayerHealth(), 0); // (the HUD draws that many hearts)
+            snapshot.waveNo = world.getWaveNo();            snapshot.boosting = world.isBoosting();
+            snapshot.fireOnHold = world.isFireOnHold();     snapshot.gameOver = world.isGameOver();
+            snapshot.fireHoldSeconds = world.fireHoldSeconds();
+            snapshot.dormantAsteroids = world.getDormantCount();
+            snapshot.stepTime = lastTime - std::chrono::duration_cast<SimClock::duration>(std::chrono::duration<float>(lag));
+            back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+        }
+
+        // run the steps the real time asks for, returns how many were run
+        short int runSteps(){
+            auto now = SimClock::now();
+            float elapsed = std::chrono::duration<float>(now - lastTime).count();
+            lastTime = now;
+
+            FrameInput input;
+            while (inputs.pop(input)){
+                pending.singleFires += input.singleFires;  pending.fireTypeChanges += input.fireTypeChanges;
+                pending.specialFire = input.specialFire;    pending.left = input.left;
+                pending.right = input.right;                pending.up = input.up;
+            }
+            if (paused.load(std::memory_order_acquire)){ pending.singleFires = pending.fireTypeChanges = 0;  return 0; }
+            bool wasResumed = resumed.exchange(false, std::memory_order_acq_rel);
+            if (wasResumed){ elapsed = 0.0F; }
+
+            lag += std::min(elapsed, 0.25F);
+            short int steps = 0;
+            for (; lag >= FRAME_SECONDS  and  steps < MAX_STEPS_PER_FRAME; ++steps){
+                if (not world.isGameOver()){ recorder.record(pending); }
+                world.step(pending);
+                lag -= FRAME_SECONDS;
+                pending.singleFires = pending.fireTypeChanges = 0;
+                for (GameEvent event : world.lastEvents()){ events.push(event); }
+                for (const EffectSpawn &effect : world.lastEffects()){ effects.push(effect); }
+            }
+            if (steps == MAX_STEPS_PER_FRAME){ lag = std::min(lag, FRAME_SECONDS); } // can't keep up
+            if (steps > 0  or  not threaded  or  wasResumed){ publish(); } // (resumed : the step time moved on)
+            return steps;
+        }
+
+        void work(){
+            while (running.load(std::memory_order_acquire)){
+                if (runSteps() == 0){ // nothing due yet, wait till the next step (or a bit while paused)
+                    float wait = (paused.load(std::memory_order_relaxed))? 0.001F : FRAME_SECONDS - lag;
+                    std::this_thread::sleep_for(std::chrono::duration<float>(std::max(wait, 0.0F)));
+                }
+            }
+        }
+
+        public :
+
+        SimThread(unsigned int width, unsigned int height, unsigned int seed, const StoreLimits &limits = StoreLimits())
+            : world(width, height, seed, limits), middle(1), back(0), front(2), lag(0.0F),
+              running(false), paused(false), resumed(false), threaded(false) {}
+        ~SimThread(){ stop(); }
+        SimThread(const SimThread &) = delete;
+        SimThread& operator=(const SimThread &) = delete;
+
+        // the world may be set up (e.g. a profiler, a large world's active range) before start() and
+        // record(), and read again after stop()
+        inline World& getWorld(){ return world; }
+
+        void start(bool onThread){
+            threaded = onThread;  lastTime = SimClock::now();
+            publish();
+            running = true;
+            if (threaded){ worker = std::thread([this]{ work(); }); }
+        }
+        void stop(){
+            running = false;
+            if (worker.joinable()){ worker.join(); }
+            recorder.close(world);
+        }
+        // log the inputs of every step into a replay file (call it before start, restart() starts it again)
+        inline bool record(const std::string &path){ replayPath = path;  return recorder.open(path, world); }
+
+        // main thread : stop the game and start a new one with the same world buffers (and replay file)
+        void restart(unsigned int seed){
+            stop();
+            FrameInput input;  GameEvent event;  EffectSpawn effect;
+            while (inputs.pop(input)){}       // the sim thread is gone, so this thread may empty its queues
+            while (events.pop(event)){}
+            while (effects.pop(effect)){}
+            world.reset(seed);
+            pending = FrameInput();  lag = 0.0F;
+            paused = false;  resumed = false;
+            if (not replayPath.empty()){ recorder.open(replayPath, world); }
+            start(threaded);
+        }
+
+        // main thread : hand over this frame's inputs (on the main thread mode the steps run here),
+        // a stopped sim (game over) takes none
+        void sendInput(const FrameInput &input){
+            if (not running.load(std::memory_order_relaxed)){ return; }
+            while (not inputs.push(input)){ std::this_thread::yield(); } // only if the sim is far behind
+            if (not threaded){ runSteps(); }
+        }
+        // main thread : pausing drops the key presses, and the paused time is not simulated later
+        void setPaused(bool pause){
+            if (paused.load(std::memory_order_relaxed) == pause){ return; }
+            if (not pause){ resumed.store(true, std::memory_order_release); }
+            else { pausedAt = SimClock::now(); }
+            paused.store(pause, std::memory_order_release);
+        }
+        // main thread : the latest complete snapshot (stays the same until the next call)
+        const RenderSnapshot& latest(){
+            if (middle.load(std::memory_order_acquire) & FRESH){
+                front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+            }
+            return snapshots[front];
+        }
+        // main thread : how far the real time is past the snapshot's last step (0 .. 1 steps), taken when it
+        // is drawn, as a snapshot of the sim thread may wait a while for that (while paused : when it paused)
+        float alphaOf(const RenderSnapshot &snapshot) const {
+            SimClock::time_point now = (paused.load(std::memory_order_relaxed))? pausedAt : SimClock::now();
+            float past = std::chrono::duration<float>(now - snapshot.stepTime).count() / FRAME_SECONDS;
+            return std::min(std::max(past, 0.0F), 1.0F);
+        }
+        // main thread : the events of the steps run since the last call, in order
+        inline bool popEvent(GameEvent &event){ return events.pop(event); }
+        // main thread : the explosions started since the last call
+        inline bool popEffect(EffectSpawn &effect){ return effects.pop(effect); }
+        inline bool isThreaded() const { return threaded; }
+    };
+}
@@ -0,0 +1,725 @@
+
+#pragma once
+// headless game simulation: all the gameplay logic lives here without any window or audio device,
+// so it can be stepped thousands of times a second (benchmarks) and the SFML front end just draws it
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <cmath>
+#include <ctime>
+#include <tuple>
+#include "BatchKernels.hpp"
+#include "EntityStore.hpp"
+#include "Profiler.hpp"
+#include "Random.hpp"
+#include "SpatialGrid.hpp"
+#include "ThreadPool.hpp"
+
+
+namespace Asteroid {
+
+    constexpr auto FRAME_SECONDS = 1.0F / 120.0F; // one simulation step (the speeds are tuned per step)
+    constexpr std::size_t PARALLEL_GRAIN = 2048;  // objects per job of the parallel update passes (smaller waves stay serial)
+                                                  // (a multiple of the SIMD lanes, so every object takes the same kernel path)
+    constexpr std::size_t BULLET_GRAIN = 64;      // bullets per job of the parallel collision pass (each tests many asteroids)
+    constexpr std::size_t CHUNK_HIT_ROOM = 16 * BULLET_GRAIN; // hits a job of it has room for (more only grow its list)
+    constexpr std::uint32_t REGION_SCAN_STEPS = 16; // large worlds : steps between two checks which asteroids sleep or wake
+    constexpr auto REGION_MARGIN = 256.0F;        // past the active range : more than the ship and an asteroid close in
+                                                  // between two checks plus their radious (checked below the ARCHETYPES)
+
+
+    /////////////////////////////// @c ANIMATION-CLIPS //////////////////////////////
+
+
+    // every animation used by the game objects
+    enum ClipId : short int {
+        SHIP_CLIP, SHIP_BOOST_CLIP, BLUE_BULLET_CLIP, RED_BULLET_CLIP, BIG_ASTEROID_CLIP,
+        SMALL_ASTEROID_CLIP, EXPLOSION_CLIP_1, EXPLOSION_CLIP_2, EXPLOSION_CLIP_3, CLIP_COUNT
+    };
+    // a clip is shared by all the objects showing it, an object only keeps its own cursor
+    // (EntityStore::frame and frameTime), so spawning an animated object copies no frame table
+    struct AnimationClip {
+        const char *sheet;               // sprite sheet with the frames in a linear row
+        short int frameW, frameH, frameCount;
+        float frameSeconds;              // how long one frame is shown, 0 = a still clip
+    };
+    constexpr AnimationClip CLIPS[CLIP_COUNT] = {
+        {"Images/Asteroid/spaceship2.png",   45,  50,  1, FRAME_SECONDS},
+        {"Images/Asteroid/spaceship2_.png",  45,  70,  1, FRAME_SECONDS},
+        {"Images/Asteroid/bluefire.png",     32,  64, 16, FRAME_SECONDS},
+        {"Images/Asteroid/redfire.png",      32,  64, 16, 0.0F},
+        {"Images/Asteroid/bigrocks.png",     64,  64, 16, 0.0F},
+        {"Images/Asteroid/smallrocks.png",   64,  64, 16, 0.0F},
+        {"Images/Asteroid/explosion1.png",   50,  50, 20, FRAME_SECONDS},
+        {"Images/Asteroid/explosion2.png",  192, 192, 64, FRAME_SECONDS},
+        {"Images/Asteroid/explosion3.png",  256, 256, 48, FRAME_SECONDS}
+    };
+
+    // move the cursor of the i'th obj by one step of time
+    inline void updateAnimation(EntityStore &store, std::size_t i){
+        const AnimationClip &clip = CLIPS[store.clip[i]];
+        if (clip.frameSeconds <= 0.0F){ return; }
+        store.frameTime[i] += FRAME_SECONDS;
+        while (store.frameTime[i] >= clip.frameSeconds){ // show every frame which is due by now
+            store.frameTime[i] -= clip.frameSeconds;
+            // if the current frame reach to the last then restart
+            if (++store.frame[i] >= clip.frameCount){ store.frame[i] = 0; }
+        }
+    }
+
+
+    /////////////////////////////// @c ENTITY-ARCHETYPES //////////////////////////////
+
+
+    // every kind of game object, each object keeps its kind (EntityStore::kind) and the rules look its
+    // traits up here, instead of telling a small asteroid or a special bullet by its radious
+    enum EntityKind : unsigned char {
+        SHIP_KIND, SINGLE_BULLET_KIND, SPECIAL_BULLET_KIND, BIG_ASTEROID_KIND, SMALL_ASTEROID_KIND, KIND_COUNT,
+        NO_SPLIT = KIND_COUNT // (Archetype::splitInto) it is just destroyed
+    };
+    constexpr unsigned char kindBit(EntityKind kind){ return static_cast<unsigned char>(1U << kind); }
+    constexpr unsigned char SHIP_KINDS = kindBit(SHIP_KIND);                                    // the ship store
+    constexpr unsigned char BULLET_KINDS = kindBit(SINGLE_BULLET_KIND) | kindBit(SPECIAL_BULLET_KIND); // the bullets store
+    constexpr unsigned char ASTEROID_KINDS = kindBit(BIG_ASTEROID_KIND) | kindBit(SMALL_ASTEROID_KIND); // the asteroids store
+
+    struct Archetype {
+        float radious, thrust, maxSpeed;
+        ClipId clip;
+        short int score;
+        EntityKind splitInto;
+        short int splitCount;
+        ClipId explosion;
+        unsigned char hitMask;
+        bool spread;
+        /*
+        radious    : collision radious
+        thrust     : speed added every step it is pushed (the boosting ship, a bullet always) (px per step)
+        maxSpeed   : top speed (px per step) : the ship is slowed down to it, an asteroid gets a random
+                     0 .. maxSpeed on each axis, 0 = no limit (a bullet speeds up till it leaves)
+        clip       : the animation it spawns with
+        score      : points for destroying it
+        splitInto  : it breaks into splitCount of these when a bullet hits it (NO_SPLIT = it is just destroyed)
+        explosion  : played where it is hit (CLIP_COUNT = none)
+        hitMask    : the kinds it collides with (kindBit)
+        spread     : turned by the spread of the fire types 2 and 3
+        */
+    };
+    constexpr Archetype ARCHETYPES[KIND_COUNT] = {
+        //  radious thrust max speed  clip           score  split into       parts  explosion         collides with               spread
+        {20.0F, 0.2F, 5.0F, SHIP_CLIP,            0, NO_SPLIT,            0, EXPLOSION_CLIP_3, ASTEROID_KINDS,             false},
+        {10.0F, 1.0F, 0.0F, BLUE_BULLET_CLIP,     0, NO_SPLIT,            0, CLIP_COUNT,       ASTEROID_KINDS,             false},
+        {11.0F, 1.0F, 0.0F, BLUE_BULLET_CLIP,     0, NO_SPLIT,            0, CLIP_COUNT,       ASTEROID_KINDS,             true },
+        {20.0F, 0.0F, 2.0F, BIG_ASTEROID_CLIP,    1, SMALL_ASTEROID_KIND, 4, EXPLOSION_CLIP_2, SHIP_KINDS | BULLET_KINDS, false},
+        {10.0F, 0.0F, 2.0F, SMALL_ASTEROID_CLIP,  0, NO_SPLIT,            0, EXPLOSION_CLIP_1, SHIP_KINDS | BULLET_KINDS, false}
+    };
+    constexpr bool splitsConsistent(){ // a kind which splits breaks into some pieces, the others into none
+        for (const Archetype &type : ARCHETYPES){ if ((type.splitInto == NO_SPLIT) != (type.splitCount == 0)){ return false; } }
+        return true;
+    }
+    static_assert(splitsConsistent(), "splitInto and splitCount disagree");
+
+    // add an object of a kind known at compile time (its traits are constants here)
+    template<EntityKind KIND> inline std::size_t spawn(EntityStore &store, float X, float Y, float degree,
+                                                       ClipId animClip = ARCHETYPES[KIND].clip){
+        return store.add(animClip, X, Y, degree, ARCHETYPES[KIND].radious, KIND);
+    }
+
+    // how many kinds of the first group collide with how many of the second one (both ways round)
+    constexpr int collidingPairs(unsigned char kindsA, unsigned char kindsB){
+        int pairs = 0;
+        for (int a = 0; a < KIND_COUNT; ++a){
+            for (int b = 0; b < KIND_COUNT; ++b){
+                if (not (kindsA & (1U << a))  or  not (kindsB & (1U << b))){ continue; }
+                pairs += (ARCHETYPES[a].hitMask & (1U << b)) != 0;
+                pairs += (ARCHETYPES[b].hitMask & (1U << a)) != 0;
+            }
+        }
+        return pairs;
+    }
+    constexpr int kindCount(unsigned char kinds){ return (kinds == 0)? 0 : (kinds & 1) + kindCount(kinds >> 1); }
+    constexpr bool allCollide(unsigned char kindsA, unsigned char kindsB){
+        return collidingPairs(kindsA, kindsB) == 2 * kindCount(kindsA) * kindCount(kindsB);
+    }
+    // the collision passes test whole stores against each other (the bullets and the ship against the
+    // asteroids) without looking at the kinds, so the table must say exactly that
+    static_assert(allCollide(BULLET_KINDS, ASTEROID_KINDS)  and  allCollide(SHIP_KINDS, ASTEROID_KINDS), "untested pair");
+    static_assert(collidingPairs(SHIP_KINDS, BULLET_KINDS) == 0  and  collidingPairs(BULLET_KINDS, BULLET_KINDS) == 0
+                  and  collidingPairs(ASTEROID_KINDS, ASTEROID_KINDS) == 0, "a pair no pass tests");
+    // the bullet kernel speeds all the bullets up at once
+    static_assert(ARCHETYPES[SINGLE_BULLET_KIND].thrust == ARCHETYPES[SPECIAL_BULLET_KIND].thrust, "one bullet thrust");
+
+    // biggest collision radious (the collision grid cells are twice as big)
+    constexpr float maxRadious(){
+        float radious = 0.0F;
+        for (const Archetype &type : ARCHETYPES){ radious = std::max(radious, type.radious); }
+        return radious;
+    }
+    constexpr auto MAX_RADIOUS = maxRadious();
+    // (a sleeping asteroid must not come near the ship before the next check, see World::sleepAndWake :
+    // the ship and the asteroid close in by their top speeds, the asteroid's on both axes)
+    constexpr float ASTEROID_MAX_SPEED = std::max(ARCHETYPES[BIG_ASTEROID_KIND].maxSpeed, ARCHETYPES[SMALL_ASTEROID_KIND].maxSpeed);
+    static_assert(REGION_MARGIN >= REGION_SCAN_STEPS * (ARCHETYPES[SHIP_KIND].maxSpeed + 2 * ASTEROID_MAX_SPEED) + 2 * MAX_RADIOUS,
+                  "the large world margin is too small");
+
+
+    ////////////////////////////////// @c COLLISION-DETECTION-FUNCTION //////////////////////////////////
+
+
+    inline bool isCollided(const EntityStore &store1, std::size_t i, const EntityStore &store2, std::size_t j){
+
+        // collision check between two objs using maths ---circle distance formula---
+        auto distanceSquareX = (store1.x[i] - store2.x[j]) * (store1.x[i] - store2.x[j]);
+        auto distanceSquareY = (store1.y[i] - store2.y[j]) * (store1.y[i] - store2.y[j]);
+        auto distanceSquareR = (store1.R[i] + store2.R[j]) * (store1.R[i] + store2.R[j]); // R -> radious
+
+        return (distanceSquareX + distanceSquareY  <  distanceSquareR);
+    }
+
+    // the same check along the last step of both objs (moved by dx, dy) : a bullet speeds up every
+    // step and soon moves farther than R1 + R2, so checking only where it ended would let it pass
+    // through a small asteroid, here the closest point of its path (seen from the other obj) is checked
+    inline bool isSweptCollided(const EntityStore &store1, std::size_t i, const EntityStore &store2, std::size_t j){
+        float moveX = store1.dx[i] - store2.dx[j], moveY = store1.dy[i] - store2.dy[j];
+        float endX = store1.x[i] - store2.x[j], endY = store1.y[i] - store2.y[j];
+        float startX = endX - moveX, startY = endY - moveY;
+
+        float moveSquare = moveX * moveX + moveY * moveY, t = 1.0F; // how far along the move the closest point is
+        if (moveSquare > 0.0F){ t = std::min(std::max(-(startX * moveX + startY * moveY) / moveSquare, 0.0F), 1.0F); }
+        float closestX = startX + moveX * t, closestY = startY + moveY * t;
+        float reach = store1.R[i] + store2.R[j];
+        return (closestX * closestX + closestY * closestY  <  reach * reach);
+    }
+
+
+    ////////////////////////////////// @c WORLD-INPUT-AND-EVENTS //////////////////////////////////
+
+
+    struct FrameInput { // everything the player did during one frame
+        short int singleFires = 0;     // SPACE presses (single bullets)
+        short int fireTypeChanges = 0; // DOWN-ARROW presses (change special fire type)
+        bool specialFire = false;      // LEFT-SHIFT held (continious fire)
+        bool left = false, right = false, up = false; // held arrow keys
+    };
+
+    // things happened inside a step which the front end may want to play or show
+    enum GameEvent : short int {
+        SINGLE_FIRE_EVENT, SPECIAL_FIRE_EVENT_1, SPECIAL_FIRE_EVENT_2, SHIP_HIT_EVENT, NEW_WAVE_EVENT, GAME_OVER_EVENT
+    };
+
+    // an explosion started inside a step : only a picture, the front end plays it (EffectSystem)
+    struct EffectSpawn {
+        short int clip;
+        float x, y;
+    };
+
+    // capacity of every object store, the world allocates them once and normal play stays below
+    // (a full store still grows, which is counted and shown by World::printStoreReport())
+    struct StoreLimits {
+        std::size_t bullets = 1024;     // continious fire adds one per step, they live until off screen
+        std::size_t asteroids = 1024;   // the biggest wave plus 4 small ones per broken big asteroid
+    };
+
+
+    ////////////////////////////////// @c WORLD-CLASS //////////////////////////////////
+
+
+    class World { // the whole game state, advanced one frame at a time by step()
+
+        private :
+
+        float worldW, worldH, simTime;
+        unsigned int randSeed;                   // a replay needs it to play the same game again
+        RandomStreams randoms;                   // for generate random number (a stream per use, see Random.hpp)
+        EntityStore ship, bullets, asteroids, dormantAsteroids;
+        std::vector<std::uint32_t> dormantSince;
+        std::vector<std::size_t> brokenAsteroids;
+        SpatialGrid asteroidGrid;                   // broadphase for the collision pass
+        std::vector<std::uint32_t> nearAsteroids;
+        std::vector<GameEvent> events;
+        std::vector<float> bulletSpread;
+        std::vector<EffectSpawn> effectSpawns;
+        Profiler *profiler;                         // times the phases of a step (if set)
+        ThreadPool *pool;                           // splits the big passes over its workers (if set)
+        std::vector<std::vector<std::uint64_t>> chunkHits;
+
+        short int fireType, playerHealthCount, playerScore, waveLength, waveNo, effectStepsLeft, waveScale;
+        std::uint32_t stepNo;
+        float activeRangeX, activeRangeY;
+        bool spaceshipBoost, inputBlocked, continiousFireOn, holdFire, gameOver, shipInvulnerable, dormancy;
+        float inputBlockedAt, fireStartedAt, fireHoldStartedAt; // sim times used instead of clocks
+        /*
+        worldW, worldH  : size of the playing area (the background image size, or many screens of a large world)
+        simTime         : total simulated seconds, each step adds FRAME_SECONDS
+        ship            : always holds exactly one object (the player's spaceship)
+        brokenAsteroids : big asteroids hit in this step, which split into small ones
+        events          : what happened during the last step
+        effectSpawns    : the explosions started in the last step
+        bulletSpread    : the turn of every bullet of the spread fire types in this step (drawn all at once)
+        effectStepsLeft : steps till the last explosion ends (a new wave waits for it, as it always did)
+        shipInvulnerable: asteroids still explode on the ship but don't hurt or stop it (scripted runs)
+        activeRange     : large worlds, how far (each way) from the ship bullets fly and asteroids are stepped (0 = all)
+        dormantAsteroids: the asteroids farther than that, not stepped at all till the ship comes close (dormantSince
+                          = the step they fell asleep at, they are moved ahead by the steps they missed when they wake)
+        waveScale       : the waves are that many times bigger (large worlds)
+        stepNo          : steps since the game started
+        chunkHits       : (bullet << 32 | asteroid) pairs found by every job of the parallel collision pass
+        */
+        void spawnAsteroid(EntityKind kind, int X, int Y){
+            const Archetype &type = ARCHETYPES[kind];
+            Random &random = randoms[SPAWN_STREAM];
+            std::uint32_t speeds = static_cast<std::uint32_t>(type.maxSpeed) + 1;
+            float speedX = random.below(speeds), speedY = random.below(speeds); // spawn a asteroid with random values
+            std::size_t i = asteroids.add(type.clip, X, Y, random.below(360), type.radious, kind);
+            asteroids.dx[i] = speedX;  asteroids.dy[i] = speedY;
+        }
+
+        // the asteroids the i'th bullet may have touched on its last move (the grid cells around its path,
+        // the one cell margin also covers the asteroid's own move : R1 + R2 + 3 is less than a cell)
+        template<class Visit> void forEachNearPath(std::size_t i, Visit &&visit) const {
+            float fromX = bullets.x[i] - bullets.dx[i], fromY = bullets.y[i] - bullets.dy[i];
+            asteroidGrid.forEachNearBox(std::min(fromX, bullets.x[i]), std::min(fromY, bullets.y[i]),
+                                        std::max(fromX, bullets.x[i]), std::max(fromY, bullets.y[i]), visit);
+        }
+
+        void spawnEffect(ClipId animClip, float X, float Y){
+            effectSpawns.push_back({static_cast<short int>(animClip), X, Y});
+            effectStepsLeft = std::max(effectStepsLeft, CLIPS[animClip].frameCount);
+        }
+
+        // the distance on one axis, the shorter way round the wrapped world
+        static inline float wrappedDistance(float a, float b, float size){
+            float d = std::abs(a - b);
+            return std::min(d, size - d);
+        }
+        inline bool isFarFromShip(float x, float y, float reachX, float reachY) const {
+            return wrappedDistance(x, ship.x[0], worldW) > reachX  or  wrappedDistance(y, ship.y[0], worldH) > reachY;
+        }
+        // where x is after "steps" steps of x += dx with the wrapping of integrateWrap (past an edge it restarts
+        // at the other one), the positions and speeds of asteroids are whole numbers, so this is exact
+        static float wrapAhead(float x, float dx, std::uint32_t steps, float size){
+            if (dx == 0.0F  or  steps == 0){ return x; }
+            double speed = std::abs(dx), room = (dx > 0.0F)? size - x : x; // to the edge it moves to
+            double toWrap = std::floor(room / speed) + 1.0; // the step which carries it past the edge
+            if (steps < toWrap){ return static_cast<float>(x + static_cast<double>(steps) * dx); }
+            double period = std::floor(size / speed) + 1.0, left = std::fmod(steps - toWrap, period);
+            return static_cast<float>(((dx > 0.0F)? 0.0 : size) + left * dx);
+        }
+        void sleepAndWake();
+        void wakeAsteroid(std::size_t i);
+
+        void hitAsteroid(std::size_t i, std::size_t j);
+        void collideBullets();
+        void collideBulletsParallel();
+        void updateShip();
+        void updateBullets();
+        void updateAsteroids();
+
+        public :
+
+        World(unsigned int width, unsigned int height, unsigned int seed = static_cast<unsigned>(std::time(nullptr)),
+              const StoreLimits &limits = StoreLimits())
+            : worldW(width), worldH(height), simTime(0.0F), randSeed(seed), randoms(seed),
+              profiler(nullptr), pool(nullptr){
+
+            // every buffer the steps use is allocated here, so playing doesn't touch the heap
+            ship.reserve(1);  bullets.reserve(limits.bullets);  asteroids.reserve(limits.asteroids);
+            dormantAsteroids.reserve(limits.asteroids);  dormantSince.reserve(limits.asteroids);
+            brokenAsteroids.reserve(limits.asteroids);  nearAsteroids.reserve(limits.asteroids);  events.reserve(64);
+            effectSpawns.reserve(limits.asteroids);  bulletSpread.reserve(limits.bullets);
+            asteroidGrid.resize(worldW, worldH, 2 * MAX_RADIOUS);
+            asteroidGrid.reserve(limits.asteroids);
+            chunkHits.resize((limits.bullets + BULLET_GRAIN - 1) / BULLET_GRAIN);
+            for (std::vector<std::uint64_t> &hits : chunkHits){ hits.reserve(CHUNK_HIT_ROOM); }
+            shipInvulnerable = false;  dormancy = true;  waveScale = 1;
+            activeRangeX = activeRangeY = 0.0F;
+            reset(seed);
+        }
+
+        // start a new game (keeps the buffers, the profiler, the pool, the invulnerability and the large world settings)
+        void reset(unsigned int seed){
+            simTime = 0.0F;  stepNo = 0;  randSeed = seed;  randoms.seed(seed);
+            fireType = 1;  playerHealthCount = 5;  playerScore = waveLength = waveNo = effectStepsLeft = 0;
+            spaceshipBoost = inputBlocked = continiousFireOn = holdFire = gameOver = false;
+            inputBlockedAt = fireStartedAt = fireHoldStartedAt = 0.0F;
+            for (EntityStore *store : {&ship, &bullets, &asteroids, &dormantAsteroids}){ store->clear(); }
+            dormantSince.clear();  events.clear();  effectSpawns.clear();
+            spawn<SHIP_KIND>(ship, 400, 400, 0);
+        }
+
+        void step(const FrameInput &input);
+        void startWave(int asteroidCount);
+        inline void setShipInvulnerable(bool invulnerable){ shipInvulnerable = invulnerable; }
+        // large worlds : bullets die farther than (rangeX, rangeY) from the ship, and the asteroids a bit farther
+        // sleep until it comes close (with "dormant" false they are all stepped, the game is exactly the same)
+        inline void setActiveRange(float rangeX, float rangeY, bool dormant = true){
+            activeRangeX = rangeX;  activeRangeY = rangeY;  dormancy = dormant;
+            if (not dormancy  or  rangeX <= 0.0F){ wakeAll(); }
+        }
+        inline void setWaveScale(short int scale){ waveScale = std::max<short int>(scale, 1); }
+        // step every sleeping asteroid up to now and put it back into play
+        void wakeAll(){ while (not dormantAsteroids.empty()){ wakeAsteroid(dormantAsteroids.size() - 1); } }
+        inline void setProfiler(Profiler *frameProfiler){ profiler = frameProfiler; }
+        // the results are exactly the same with or without a pool, only the speed differs
+        inline void setThreadPool(ThreadPool *workers){ pool = workers; }
+
+        inline const EntityStore& getShip() const { return ship; }
+        inline const EntityStore& getBullets() const { return bullets; }
+        inline const EntityStore& getAsteroids() const { return asteroids; }
+        inline std::size_t getDormantCount() const { return dormantAsteroids.size(); }
+        inline const std::vector<GameEvent>& lastEvents() const { return events; }
+        inline const std::vector<EffectSpawn>& lastEffects() const { return effectSpawns; }
+        inline short int getPlayerScore() const { return playerScore; }
+        inline short int getPlayerHealth() const { return playerHealthCount; }
+        inline short int getWaveNo() const { return waveNo; }
+        inline short int getFireType() const { return fireType; }
+        inline bool isBoosting() const { return spaceshipBoost; }
+        inline bool isFireOnHold() const { return holdFire; }
+        inline bool isGameOver() const { return gameOver; }
+        inline float fireHoldSeconds() const { return simTime - fireHoldStartedAt; }
+        inline float getWidth() const { return worldW; }
+        inline float getHeight() const { return worldH; }
+        inline unsigned int getSeed() const { return randSeed; }
+        inline float getActiveRangeX() const { return activeRangeX; }
+        inline float getActiveRangeY() const { return activeRangeY; }
+        inline short int getWaveScale() const { return waveScale; }
+
+        // FNV-1a over everything the steps change (objects, score, health, wave), equal hashes = equal games
+        std::uint64_t stateHash() const {
+            std::uint64_t hash = 14695981039346656037ULL;
+            auto mix = [&hash](const void *data, std::size_t size){
+                const unsigned char *bytes = static_cast<const unsigned char*>(data);
+                for (std::size_t k = 0; k < size; ++k){ hash = (hash ^ bytes[k]) * 1099511628211ULL; }
+            };
+            for (const EntityStore *store : {&ship, &bullets, &asteroids, &dormantAsteroids}){
+                std::size_t count = store->size();
+                mix(store->x.data(), count * sizeof(float));      mix(store->y.data(), count * sizeof(float));
+                mix(store->dx.data(), count * sizeof(float));     mix(store->dy.data(), count * sizeof(float));
+                mix(store->angle.data(), count * sizeof(float));  mix(store->life.data(), count);
+                mix(store->clip.data(), count * sizeof(short int));  mix(store->frame.data(), count * sizeof(short int));
+            }
+            short int counters[] = { playerScore, playerHealthCount, waveNo, fireType, effectStepsLeft };
+            mix(counters, sizeof(counters));
+            mix(dormantSince.data(), dormantSince.size() * sizeof(std::uint32_t));
+            return hash;
+        }
+
+        // the peak occupancy of every store against its capacity
+        void printStoreReport() const {
+            std::printf("%12s %8s %8s %8s\n", "store", "peak", "capacity", "growths");
+            for (auto store : { std::make_pair("bullets", &bullets), std::make_pair("asteroids", &asteroids),
+                                std::make_pair("dormant", &dormantAsteroids) }){
+                std::printf("%12s %8zu %8zu %8u\n", store.first, store.second->getPeak(),
+                            store.second->getCapacity(), store.second->getGrowths());
+            }
+        }
+    };
+
+
+    ////////////////////////////////// @c BULLET-COLLISION-LOGIC //////////////////////////////////
+
+
+    inline void World::hitAsteroid(std::size_t i, std::size_t j){
+        const Archetype &type = ARCHETYPES[asteroids.kind[j]];
+        bullets.life[i] = asteroids.life[j] = DEAD;
+        // a small asteroid is not broken furthur, a big one splits (in the spawn phase)
+        if (type.splitInto != NO_SPLIT){ asteroids.life[j] = BROKEN;  brokenAsteroids.push_back(j); }
+        playerScore += type.score; // only a big asteroid scores
+        // create a explosion effect based on the asteroid type
+        spawnEffect(type.explosion, asteroids.x[j], asteroids.y[j]);
+    }
+
+    inline void World::collideBullets(){
+        for (std::size_t i = 0; i < bullets.size(); ++i){
+            nearAsteroids.clear();
+            forEachNearPath(i, [&](std::uint32_t j){
+                // a broken big asteroid is already split, so it can't be hit again
+                if (asteroids.life[j] != BROKEN  and  isSweptCollided(bullets, i, asteroids, j)){ nearAsteroids.push_back(j); }
+            });
+            if (nearAsteroids.size() > 1){ std::sort(nearAsteroids.begin(), nearAsteroids.end()); }
+
+            for (std::size_t j : nearAsteroids){ hitAsteroid(i, j); }
+        }
+    }
+
+    // the jobs only find the touching pairs (positions don't change in this pass), the hits are then
+    // applied here in bullet and asteroid order : the same order, so the same score, life flags and
+    // spawns as collideBullets() (only a big asteroid broken by an earlier bullet has to be skipped)
+    inline void World::collideBulletsParallel(){
+        std::size_t chunks = (bullets.size() + BULLET_GRAIN - 1) / BULLET_GRAIN;
+        if (chunkHits.size() < chunks){ chunkHits.resize(chunks); }
+
+        pool->parallelFor(bullets.size(), BULLET_GRAIN, [this](std::size_t from, std::size_t to){
+            std::vector<std::uint64_t> &hits = chunkHits[from / BULLET_GRAIN];
+            hits.clear();
+            for (std::size_t i = from; i < to; ++i){
+                std::size_t firstHit = hits.size();
+                forEachNearPath(i, [&](std::uint32_t j){
+                    if (isSweptCollided(bullets, i, asteroids, j)){ hits.push_back(static_cast<std::uint64_t>(i) << 32 | j); }
+                });
+                std::sort(hits.begin() + firstHit, hits.end());
+            }
+        });
+        for (std::size_t c = 0; c < chunks; ++c){
+            for (std::uint64_t hit : chunkHits[c]){
+                std::size_t i = hit >> 32, j = hit & 0xFFFFFFFFU;
+                if (asteroids.life[j] != BROKEN){ hitAsteroid(i, j); }
+            }
+        }
+    }
+
+
+    ////////////////////////////////// @c OBJECTS-UPDATE-LOGIC //////////////////////////////////
+
+
+    inline void World::updateShip(){
+        float &x = ship.x[0], &y = ship.y[0], &dx = ship.dx[0], &dy = ship.dy[0], angle = ship.angle[0];
+
+        if (spaceshipBoost){ // if user boosted the ship by up-arraow then increase speed
+            dx += std::cos(angle * DEG_TO_RAD) * ARCHETYPES[SHIP_KIND].thrust;
+            dy += std::sin(angle * DEG_TO_RAD) * ARCHETYPES[SHIP_KIND].thrust;
+        }
+        else { dx *= 0.99F;  dy *= 0.99F; } // otherwise decrease the speed gradually
+
+        // prevent the ship speed to become too much fast
+        float maxSpeed = ARCHETYPES[SHIP_KIND].maxSpeed, speed = std::sqrt(dx * dx  +  dy * dy);
+        if (speed > maxSpeed){ dx *= maxSpeed / speed;  dy *= maxSpeed / speed; }
+
+        x += dx;  y += dy;
+
+        // screen wrapping
+        // if the ship moves off one side of the screen then it reappears on other side
+        if (x < 0.0F){ x = worldW; }
+        if (y < 0.0F){ y = worldH; }
+        if (x > worldW){ x = 0.0F; }
+        if (y > worldH){ y = 0.0F; }
+        updateAnimation(ship, 0);
+    }
+
+    inline void World::updateBullets(){
+        // the spread of fire types 2 (-3 .. 3 degrees) and 3 (0 .. 1000) is drawn for every bullet at once,
+        // so the pass below may run in parallel and still give the same game
+        bool spread = (fireType == 2  or  fireType == 3);
+        if (spread){
+            bulletSpread.resize(bullets.size());
+            randoms[WEAPON_STREAM].fill(bulletSpread.data(), bullets.size(), (fireType == 2)? -3 : 0, (fireType == 2)? 3 : 1000);
+        }
+        // move all the bullets at once, the out of bound ones get life = DEAD, but a large world wraps them
+        // around its edges instead (they end at the active range there, so no edge is ever seen)
+        bool ranged = (activeRangeX > 0.0F);
+        auto integrate = [this, spread, ranged](std::size_t from, std::size_t to){
+            integrateBullets(bullets.x.data() + from, bullets.y.data() + from, bullets.dx.data() + from, bullets.dy.data() + from,
+                             bullets.angle.data() + from, bullets.life.data() + from, to - from, worldW, worldH,
+                             ARCHETYPES[SINGLE_BULLET_KIND].thrust, ranged);
+            if (not spread){ return; }
+            for (std::size_t i = from; i < to; ++i){
+                // change the fire types but not effect the single fire type
+                if (ARCHETYPES[bullets.kind[i]].spread){ bullets.angle[i] += bulletSpread[i]; }
+            }
+        };
+        if (pool != nullptr){ pool->parallelFor(bullets.size(), PARALLEL_GRAIN, integrate); }
+        else { integrate(0, bullets.size()); }
+        for (std::size_t i = 0; i < bullets.size(); ){
+            updateAnimation(bullets, i);
+            // if go out of bound (or out of the active range of a large world) then remove that bullet obj
+            // (the last obj is moved into this place, so check the same index again)
+            if (bullets.life[i] == DEAD  or  (ranged  and  isFarFromShip(bullets.x[i], bullets.y[i], activeRangeX, activeRangeY))){
+                bullets.remove(i);
+            }
+            else { ++i; }
+        }
+    }
+
+    inline void World::updateAsteroids(){
+        // move and wrap all the asteroids at once (every asteroid on its own, so the parts may run in parallel)
+        auto integrate = [this](std::size_t from, std::size_t to){
+            integrateWrap(asteroids.x.data() + from, asteroids.y.data() + from, asteroids.dx.data() + from,
+                          asteroids.dy.data() + from, to - from, worldW, worldH);
+        };
+        if (pool != nullptr){ pool->parallelFor(asteroids.size(), PARALLEL_GRAIN, integrate); }
+        else { integrate(0, asteroids.size()); }
+
+        for (std::size_t i = 0; i < asteroids.size(); ){
+            updateAnimation(asteroids, i);
+            if (asteroids.life[i] != ALIVE){ asteroids.remove(i); }
+            else { ++i; }
+        }
+    }
+
+    // large worlds : the asteroids far from the ship fall asleep and the ones it comes close to wake up,
+    // a sleeping one only moves straight on (no bullet or ship comes near it), so it is moved ahead
+    // by the steps it missed when it wakes and the game goes on exactly as if it was stepped all along
+    // (the asteroid clips are still, so no frame has to catch up, and it sleeps farther than it
+    // wakes, so the ones at the border don't swap every check)
+    inline void World::sleepAndWake(){
+        float wakeX = activeRangeX + REGION_MARGIN, wakeY = activeRangeY + REGION_MARGIN;
+        for (std::size_t i = 0; i < asteroids.size(); ){
+            if (isFarFromShip(asteroids.x[i], asteroids.y[i], wakeX + REGION_MARGIN, wakeY + REGION_MARGIN)){
+                asteroids.moveTo(i, dormantAsteroids);
+                dormantSince.push_back(stepNo);
+            }
+            else { ++i; }
+        }
+        for (std::size_t i = 0; i < dormantAsteroids.size(); ){
+            std::uint32_t missed = stepNo - dormantSince[i];
+            float x = wrapAhead(dormantAsteroids.x[i], dormantAsteroids.dx[i], missed, worldW);
+            float y = wrapAhead(dormantAsteroids.y[i], dormantAsteroids.dy[i], missed, worldH);
+            if (not isFarFromShip(x, y, wakeX, wakeY)){ wakeAsteroid(i); }
+            else { ++i; }
+        }
+    }
+
+    inline void World::wakeAsteroid(std::size_t i){
+        std::uint32_t missed = stepNo - dormantSince[i];
+        dormantAsteroids.x[i] = wrapAhead(dormantAsteroids.x[i], dormantAsteroids.dx[i], missed, worldW);
+        dormantAsteroids.y[i] = wrapAhead(dormantAsteroids.y[i], dormantAsteroids.dy[i], missed, worldH);
+        dormantSince[i] = dormantSince.back();  dormantSince.pop_back(); // (the same swap as the store)
+        std::size_t j = dormantAsteroids.moveTo(i, asteroids);
+        asteroids.prevX[j] = asteroids.x[j];  asteroids.prevY[j] = asteroids.y[j];
+    }
+
+
+
+    ///////////////////////////////// @c WORLD-STEP /////////////////////////////////
+
+
+    inline void World::step(const FrameInput &input){
+
+        events.clear();  effectSpawns.clear();
+        if (gameOver){ return; }
+        simTime += FRAME_SECONDS;  ++stepNo;
+        for (EntityStore *store : {&ship, &bullets, &asteroids}){ store->savePrevious(); }
+
+        ////////////////////////// @c DIFFERENT-TYPE-BULLET-SHOOT-LOGIC /////////////////////////
+
+
+        ProfileScope timer(profiler, FIRE_PHASE);
+        for (short int i = 0; i < input.singleFires  and  not inputBlocked; ++i){
+            // create a new single bullet obj on space key input
+            spawn<SINGLE_BULLET_KIND>(bullets, ship.x[0], ship.y[0], ship.angle[0]);
+            events.push_back(SINGLE_FIRE_EVENT);
+        }
+        // changes the fire type upon keyboard down key press
+        for (short int i = 0; i < input.fireTypeChanges; ++i){ ++fireType;  if (fireType >= 4) fireType = 1; }
+
+        // shift hold for continious fire, shift released continious fire off
+        if (input.specialFire  and  not continiousFireOn){ fireStartedAt = simTime;  continiousFireOn = true; }
+        if (not input.specialFire){ continiousFireOn = false; }
+
+        if (not inputBlocked  and  continiousFireOn  and  not holdFire){
+
+            // create a new continious bullet obj
+            spawn<SPECIAL_BULLET_KIND>(bullets, ship.x[0], ship.y[0], ship.angle[0], (fireType == 1)? BLUE_BULLET_CLIP : RED_BULLET_CLIP);
+            events.push_back((fireType == 1)? SPECIAL_FIRE_EVENT_1 : SPECIAL_FIRE_EVENT_2);
+
+            // continue the continious fire upto 3 seonds then block it for recharge
+            if (simTime - fireStartedAt >= 3.0F){ holdFire = true;  fireHoldStartedAt = simTime; }
+        }
+        else { // restart the continious fire after recharged for 10 seconds
+            if (simTime - fireHoldStartedAt >= 10.0F){ holdFire = false; }
+        }
+
+        /////////////////////////// @c SHIP-MOVEMENT-LOGIC //////////////////////////
+
+
+        timer.next(SHIP_INPUT_PHASE);
+        if (not inputBlocked  and  input.right){ ship.angle[0] += 2.9F; }
+        if (not inputBlocked  and  input.left){  ship.angle[0] -= 2.9F; }
+        // cahnging the space ship image based on enable/disable boost of the space ship
+        spaceshipBoost = (not inputBlocked  and  input.up);
+        ship.clip[0] = (spaceshipBoost)? SHIP_BOOST_CLIP : SHIP_CLIP;  ship.frame[0] = 0;  ship.frameTime[0] = 0.0F;
+
+
+        ///////////////////////// @c COLLISION-DETECTION-LOGIC-AND-INPUT-HOLD ////////////////////////
+
+
+        timer.next(COLLISION_PHASE);
+        // only the asteroids in the neighbouring cells are tested, a bullet's hits are then
+        // applied in asteroid order so the outcome is the same as testing every pair in order
+        // - the ship goes first (it was the head of the old object list) : an asteroid it hit may still
+        //   be broken by a bullet in the same step, and a game over ends the step before the bullets
+        brokenAsteroids.clear();
+        asteroidGrid.build(asteroids);
+        nearAsteroids.clear();
+        asteroidGrid.forEachNear(ship.x[0], ship.y[0], [&](std::uint32_t j){
+            if (isCollided(ship, 0, asteroids, j)){ nearAsteroids.push_back(j); }
+        });
+        if (nearAsteroids.size() > 1){ std::sort(nearAsteroids.begin(), nearAsteroids.end()); }
+
+        for (std::size_t j : nearAsteroids){
+
+            // upon collision between player and asteroid
+            asteroids.life[j] = DEAD;
+            // create a different explosion effect for the spaceship colliding
+            spawnEffect(ARCHETYPES[SHIP_KIND].explosion, ship.x[0], ship.y[0]);
+            events.push_back(SHIP_HIT_EVENT);
+            if (shipInvulnerable){ continue; }
+            --playerHealthCount;
+
+            // block the ship movements after the collsion for some times by holding keyboard inputs
+            inputBlocked = true;  inputBlockedAt = simTime;
+            ship.dx[0] = ship.dy[0] = 0;
+
+            // ------------------ Game Over Logic -----------------
+            if (playerHealthCount <= 0){ gameOver = true;  break; } // the first fatal hit ends the game (the rest don't count)
+        }
+        if (gameOver){ events.push_back(GAME_OVER_EVENT);  return; }
+        if (pool != nullptr  and  bullets.size() > BULLET_GRAIN  and  asteroids.size() >= PARALLEL_GRAIN){ collideBulletsParallel(); }
+        else { collideBullets(); }
+        // released the input flag and again allow keyboard inputs after holding for 1/2 seconds
+        if (inputBlocked  and  simTime - inputBlockedAt >= 0.5F){ inputBlocked = false; }
+
+
+        ///////////////////////////// @c SPAWN-NEW-SMALL-ASTEROIDS //////////////////////////////
+
+
+        timer.next(SPAWN_PHASE);
+        if (activeRangeX > 0.0F  and  brokenAsteroids.size() > 1){
+            // (in a large world the store order depends on which asteroids slept, so the ones a bullet
+            // broke at once are taken by place instead, and the small ones get the same random speeds)
+            std::sort(brokenAsteroids.begin(), brokenAsteroids.end(), [this](std::size_t j, std::size_t k){
+                return std::tie(asteroids.y[j], asteroids.x[j], asteroids.dy[j], asteroids.dx[j])
+                     < std::tie(asteroids.y[k], asteroids.x[k], asteroids.dy[k], asteroids.dx[k]);
+            });
+        }
+        for (std::size_t j : brokenAsteroids){
+            const Archetype &type = ARCHETYPES[asteroids.kind[j]];
+            for (short int i = 0; i < type.splitCount; ++i){
+                spawnAsteroid(type.splitInto, asteroids.x[j], asteroids.y[j]);
+            }
+        }
+
+        ///////////////////////// @c ALL-OBJECTS-UPDATE-LOGIC-FOR-EACH-FRAME ////////////////////////
+
+
+        // update the game objects kind by kind and remove if not needed
+        timer.next(UPDATE_PHASE);
+        updateShip();
+        updateBullets();
+        updateAsteroids();
+        if (activeRangeX > 0.0F  and  dormancy  and  stepNo % REGION_SCAN_STEPS == 0){ sleepAndWake(); }
+        if (effectStepsLeft > 0){ --effectStepsLeft; } // the explosions themselves are only drawn, by the front end
+
+        //////////////////////////// @c CREATE-A-NEW-WAVE /////////////////////////
+
+
+        // create asteroid objects randomly based on wave format
+        timer.next(WAVE_PHASE);
+        if (bullets.empty()  and  asteroids.empty()  and  dormantAsteroids.empty()  and  effectStepsLeft == 0){ // only the spaceship is left (and no explosion plays)
+            waveLength += 5;       // increase the wave length whenever player clears a wave successfully
+            startWave(waveLength * waveScale);
+        }
+    }
+
+    // spawn a wave of big asteroids at random places (scripted runs call it to start any wave size)
+    inline void World::startWave(int asteroidCount){
+        waveNo++;              // track the wave no.
+        events.push_back(NEW_WAVE_EVENT);
+
+        for (int i = 0; i < asteroidCount; ++i){
+            Random &random = randoms[SPAWN_STREAM];
+            int X = random.below(static_cast<int>(worldW)), Y = random.below(static_cast<int>(worldH));
+            spawnAsteroid(BIG_ASTEROID_KIND, X, Y);
+        }
+    }
+}
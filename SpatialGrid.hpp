@@ -0,0 +1,83 @@
+
+#pragma once
+// uniform grid broadphase for the collision pass: asteroids are bucketed into cells once per step,
+// then the ship only tests the asteroids of its own and the 8 neighbouring cells, and a bullet the
+// cells around the line it moved along in the last step
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "EntityStore.hpp"
+
+
+namespace Asteroid {
+
+    class SpatialGrid {
+
+        private :
+
+        float cellSize;
+        int cols, rows;
+        std::vector<std::uint32_t> cellStart, cellFill, cellItems, itemCell;
+        /*
+        cellSize  : width of a cell, at least the biggest (R1 + R2) so a 3x3 block covers every possible hit
+        cellStart : cell c holds cellItems[cellStart[c] .. cellStart[c+1]), items are store indices
+        itemCell  : cell of every store index,  cellFill : write cursor of every cell while filling
+        collision is not wrapped around the screen (isCollided uses the plain distance),
+        so positions on or just past the world edges are clamped into the border cells
+        */
+        inline int cellX(float x) const { return std::min(std::max(static_cast<int>(x / cellSize), 0), cols - 1); }
+        inline int cellY(float y) const { return std::min(std::max(static_cast<int>(y / cellSize), 0), rows - 1); }
+
+        public :
+
+        SpatialGrid() noexcept { cellSize = 1.0F;  cols = rows = 1; }
+
+        // width, height : world size,  maxReach : biggest R1 + R2 of any pair which may be tested
+        void resize(float width, float height, float maxReach){
+            cellSize = maxReach;
+            cols = std::max(1, static_cast<int>(std::ceil(width / cellSize)));
+            rows = std::max(1, static_cast<int>(std::ceil(height / cellSize)));
+            cellStart.assign(cols * rows + 1, 0);
+        }
+
+        // make room for that many objects, so building the grid doesn't allocate
+        void reserve(std::size_t count){ itemCell.reserve(count);  cellItems.reserve(count); }
+
+        // bucket every object of the store (counting sort, so each cell keeps the indices in order)
+        void build(const EntityStore &store){
+            std::fill(cellStart.begin(), cellStart.end(), 0);
+            itemCell.resize(store.size());
+            cellItems.resize(store.size());
+
+            for (std::size_t i = 0; i < store.size(); ++i){
+                itemCell[i] = cellY(store.y[i]) * cols + cellX(store.x[i]);
+                ++cellStart[itemCell[i] + 1];
+            }
+            for (std::size_t c = 1; c < cellStart.size(); ++c){ cellStart[c] += cellStart[c - 1]; }
+
+            // fill in index order, so every cell ends up with its indices ascending
+            cellFill.assign(cellStart.begin(), cellStart.end() - 1);
+            for (std::size_t i = 0; i < store.size(); ++i){ cellItems[cellFill[itemCell[i]]++] = i; }
+        }
+
+        // call visit(index) for every object stored in the cells the box touches and their neighbours
+        // (the cells are walked row by row, so the indices are not in ascending order overall)
+        template<class Visit> void forEachNearBox(float minX, float minY, float maxX, float maxY, Visit &&visit) const {
+            int fromX = std::max(cellX(minX) - 1, 0), toX = std::min(cellX(maxX) + 1, cols - 1);
+            for (int ny = std::max(cellY(minY) - 1, 0); ny <= std::min(cellY(maxY) + 1, rows - 1); ++ny){
+                // the neighbouring cells of one row are stored one after another
+                std::uint32_t from = cellStart[ny * cols + fromX], to = cellStart[ny * cols + toX + 1];
+                for (std::uint32_t k = from; k < to; ++k){ visit(cellItems[k]); }
+            }
+        }
+        // the 3x3 cells around (x, y)
+        template<class Visit> void forEachNear(float x, float y, Visit &&visit) const {
+            forEachNearBox(x, y, x, y, std::forward<Visit>(visit));
+        }
+
+        inline int getCellCount() const { return cols * rows; }
+    };
+}
@@ -0,0 +1,171 @@
+
+#pragma once
+// the sprite sheets are packed into a few atlas pages, and every frame all the sprites of one
+// page (and layer) are drawn with a single vertex array, so a frame costs a handful of draw calls
+// however many objects are on the screen
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace Asteroid {
+
+    ////////////////////////////////// @c TEXTURE-ATLAS-CLASS //////////////////////////////////
+
+
+    class TextureAtlas {
+
+        public :
+
+        struct Frame { short int page;  sf::IntRect rect; }; // where a frame of a sheet ended up
+        struct Sheet {                                        // a sprite sheet with its frames in one row
+            std::string name;
+            const sf::Image *image;
+            short int frameW, frameH, frameCount;
+        };
+
+        private :
+
+        std::vector<std::unique_ptr<sf::Texture>> pages;
+        std::map<std::string, std::vector<Frame>> regions;
+        static constexpr int PADDING = 2; // empty pixels between two frames
+
+        public :
+
+        // the frames are cut out of the (long, single row) sheets and repacked in blocks of nearly
+        // square rows (a 48 frame strip becomes 7 x 7 frames), so no page is wider than pageSize
+        // however many frames a sheet has, then the blocks are placed by shelf packing : sorted by
+        // height, in rows, a new page when a page is full (a sheet too big for a page is split over
+        // more blocks), every page is only as big as its frames need
+        void build(const std::vector<Sheet> &sheets, unsigned int pageSize){
+            pages.clear();  regions.clear();
+            const int size = pageSize;
+
+            struct Block { std::size_t sheet;  short int first, count, columns; };
+            std::vector<Block> blocks;
+            for (std::size_t i = 0; i < sheets.size(); ++i){
+                const Sheet &sheet = sheets[i];
+                int columns = std::max(1, std::min(static_cast<int>(std::ceil(std::sqrt(static_cast<float>(sheet.frameCount)))),
+                                                   (size + PADDING) / (sheet.frameW + PADDING)));
+                int rows = std::max(1, (size + PADDING) / (sheet.frameH + PADDING));
+                for (short int first = 0; first < sheet.frameCount; first += columns * rows){
+                    short int count = std::min(sheet.frameCount - first, columns * rows);
+                    blocks.push_back({i, first, count, static_cast<short int>(std::min<int>(columns, count))});
+                }
+                regions[sheet.name].resize(sheet.frameCount);
+            }
+            auto blockW = [&](const Block &b){ return b.columns * (sheets[b.sheet].frameW + PADDING) - PADDING; };
+            auto blockH = [&](const Block &b){ return (b.count + b.columns - 1) / b.columns * (sheets[b.sheet].frameH + PADDING) - PADDING; };
+            std::stable_sort(blocks.begin(), blocks.end(), [&](const Block &a, const Block &b){ return blockH(a) > blockH(b); });
+
+            std::vector<std::pair<const Block*, sf::Vector2i>> placed; // blocks on the page being filled
+            int shelfX = 0, shelfY = 0, shelfH = 0, pageW = 0;
+            auto finishPage = [&](){
+                if (placed.empty()){ return; }
+                sf::Image page;
+                page.create(pageW, shelfY + shelfH, sf::Color::Transparent);
+                for (auto &each : placed){
+                    const Block &b = *each.first;
+                    const Sheet &sheet = sheets[b.sheet];
+                    std::vector<Frame> &frames = regions[sheet.name];
+                    for (short int k = 0; k < b.count; ++k){
+                        sf::IntRect rect(each.second.x + (k % b.columns) * (sheet.frameW + PADDING),
+                                         each.second.y + (k / b.columns) * (sheet.frameH + PADDING), sheet.frameW, sheet.frameH);
+                        page.copy(*sheet.image, rect.left, rect.top,
+                                  sf::IntRect((b.first + k) * sheet.frameW, 0, sheet.frameW, sheet.frameH));
+                        frames[b.first + k] = Frame{ static_cast<short int>(pages.size()), rect };
+                    }
+                }
+                pages.emplace_back(new sf::Texture());
+                pages.back()->loadFromImage(page);
+                placed.clear();  shelfX = shelfY = shelfH = pageW = 0;
+            };
+
+            for (const Block &b : blocks){
+                int w = blockW(b), h = blockH(b);
+                if (shelfX + w > size){ shelfX = 0;  shelfY += shelfH + PADDING;  shelfH = 0; }
+                if (shelfY + h > size){ finishPage(); }
+                // (a single frame bigger than a page still gets a page of its own, as big as the frame)
+                placed.emplace_back(&b, sf::Vector2i(shelfX, shelfY));
+                shelfX += w + PADDING;  shelfH = std::max(shelfH, h);  pageW = std::max(pageW, shelfX - PADDING);
+            }
+            finishPage();
+        }
+
+        inline const std::vector<Frame>& region(const std::string &sheet) const { return regions.at(sheet); }
+        inline const sf::Texture& page(short int i) const { return *pages[i]; }
+        inline std::size_t pageCount() const { return pages.size(); }
+        // the video memory of a page (4 bytes a pixel)
+        inline std::size_t pageBytes(short int i) const { return 4ULL * pages[i]->getSize().x * pages[i]->getSize().y; }
+    };
+
+
+    ////////////////////////////////// @c SPRITE-BATCH-CLASS //////////////////////////////////
+
+
+    class SpriteBatch {
+
+        private :
+
+        const TextureAtlas &atlas;
+        short int layerCount;
+        std::vector<sf::VertexArray> batches; // [layer * pageCount + page]
+        unsigned int drawCalls, spriteCount;
+
+        public :
+
+        SpriteBatch(const TextureAtlas &textureAtlas, short int layers) : atlas(textureAtlas){
+            layerCount = layers;  drawCalls = spriteCount = 0;
+            batches.assign(layers * atlas.pageCount(), sf::VertexArray(sf::Triangles));
+        }
+
+        // forget the sprites of the last frame (the vertex arrays keep their memory)
+        void clear(){
+            for (sf::VertexArray &batch : batches){ batch.clear(); }
+            spriteCount = 0;
+        }
+
+        // add a sprite : the page rect drawn at (x, y) rotated by degree around origin (like sf::Sprite),
+        // its pixels multiplied by tint (e.g. a lower alpha fades it)
+        void add(short int layer, short int page, const sf::IntRect &rect, float originX, float originY,
+                 float x, float y, float degree, sf::Color tint = sf::Color::White){
+            sf::VertexArray &batch = batches[layer * atlas.pageCount() + page];
+            float radian = degree * 0.017453292F, c = std::cos(radian), s = std::sin(radian);
+            float left = -originX, top = -originY, right = rect.width - originX, bottom = rect.height - originY;
+
+            auto corner = [&](float localX, float localY, int u, int v){
+                return sf::Vertex(sf::Vector2f(x + localX * c - localY * s, y + localX * s + localY * c), tint,
+                                  sf::Vector2f(static_cast<float>(u), static_cast<float>(v)));
+            };
+            sf::Vertex topLeft     = corner(left,  top,    rect.left,              rect.top);
+            sf::Vertex topRight    = corner(right, top,    rect.left + rect.width, rect.top);
+            sf::Vertex bottomRight = corner(right, bottom, rect.left + rect.width, rect.top + rect.height);
+            sf::Vertex bottomLeft  = corner(left,  bottom, rect.left,              rect.top + rect.height);
+            // two triangles per sprite
+            batch.append(topLeft);  batch.append(topRight);     batch.append(bottomRight);
+            batch.append(topLeft);  batch.append(bottomRight);  batch.append(bottomLeft);
+            ++spriteCount;
+        }
+
+        // draw the layers from the bottom one, every non empty page batch is one draw call
+        void draw(sf::RenderTarget &target){
+            drawCalls = 0;
+            for (short int layer = 0; layer < layerCount; ++layer){
+                for (std::size_t page = 0; page < atlas.pageCount(); ++page){
+                    const sf::VertexArray &batch = batches[layer * atlas.pageCount() + page];
+                    if (batch.getVertexCount() == 0){ continue; }
+                    target.draw(batch, sf::RenderStates(&atlas.page(page)));
+                    ++drawCalls;
+                }
+            }
+        }
+
+        inline unsigned int getDrawCalls() const { return drawCalls; }
+        inline unsigned int getSpriteCount() const { return spriteCount; }
+    };
+}
@@ -0,0 +1,137 @@
+
+#pragma once
+// keeps the textures of the game under a memory budget : every texture is tracked with the bytes it
+// holds on the GPU (4 a pixel) and in the main memory (pixels not uploaded yet), the ones always
+// drawn are pinned (the atlas pages, the HUD), the others (the alternate backgrounds) are only
+// loaded on their first use and the least recently used of them are evicted when over the budget
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include "AssetManager.hpp"
+
+
+namespace Asteroid {
+
+    class TextureManager {
+
+        private :
+
+        struct Entry {
+            std::size_t gpuBytes, cpuBytes; // cpuBytes : only for the tracked ones (see printReport)
+            unsigned long lastUse;
+            unsigned int loads;
+            bool pinned, resident, smooth, owned;
+            /*
+            lastUse : frame it was last drawn (the oldest is evicted first)
+            loads   : how many times it was loaded (more than once = it was evicted in between)
+            owned   : loaded through the AssetManager (otherwise only counted, e.g. an atlas page)
+            */
+        };
+
+        AssetManager &assets;
+        std::map<std::string, Entry> entries;
+        std::size_t budget, gpuBytes, peakBytes;
+        unsigned long frameNo;
+        unsigned int evictions;
+
+        Entry& entry(const std::string &name, bool smooth){
+            // (try_emplace : no node is made when it is already there, get() runs every frame)
+            auto placed = entries.try_emplace(name, Entry{0, 0, 0, 0, false, false, smooth, true});
+            return placed.first->second;
+        }
+
+        // evict the least recently used textures (not pinned, not drawn this frame) till all fit
+        void fitBudget(){
+            while (gpuBytes > budget){
+                Entry *oldest = nullptr;  const std::string *oldestName = nullptr;
+                for (auto &each : entries){
+                    Entry &e = each.second;
+                    if (e.pinned  or  not e.resident  or  not e.owned  or  e.lastUse == frameNo){ continue; }
+                    if (oldest == nullptr  or  e.lastUse < oldest->lastUse){ oldest = &e;  oldestName = &each.first; }
+                }
+                if (oldest == nullptr){ return; } // all in use, the budget is too small for one frame
+                assets.unload(*oldestName);
+                gpuBytes -= oldest->gpuBytes;
+                oldest->gpuBytes = 0;  oldest->resident = false;
+                ++evictions;
+            }
+        }
+
+        public :
+
+        TextureManager(AssetManager &assetManager, std::size_t budgetBytes) noexcept : assets(assetManager){
+            budget = budgetBytes;  gpuBytes = peakBytes = 0;  frameNo = 0;  evictions = 0;
+        }
+        TextureManager(const TextureManager &) = delete;
+        TextureManager& operator=(const TextureManager &) = delete;
+
+        // start decoding a texture on the workers, so its first get() doesn't wait (e.g. the next background)
+        void prefetch(const std::string &name, bool smooth = false){
+            Entry &e = entry(name, smooth);
+            if (not assets.isRequested(name)){ assets.loadTexture(name, e.smooth); }
+        }
+
+        // the texture, loaded now if it is not resident (waits for its decoding), counts as drawn this frame
+        const sf::Texture& get(const std::string &name, bool smooth = false){
+            Entry &e = entry(name, smooth);
+            e.lastUse = frameNo;
+            if (e.resident){ return assets.texture(name); }
+
+            if (not assets.isRequested(name)){ assets.loadTexture(name, e.smooth); }
+            const sf::Texture &texture = assets.texture(name);
+            e.gpuBytes = 4ULL * texture.getSize().x * texture.getSize().y;
+            e.resident = true;  ++e.loads;
+            gpuBytes += e.gpuBytes;  peakBytes = std::max(peakBytes, gpuBytes);
+            fitBudget();
+            return texture;
+        }
+        // a texture which is never evicted (loaded now)
+        const sf::Texture& pin(const std::string &name, bool smooth = false){
+            const sf::Texture &texture = get(name, smooth);
+            entries.at(name).pinned = true;
+            return texture;
+        }
+        // count a texture owned by someone else (e.g. an atlas page), it is pinned
+        void track(const std::string &name, std::size_t gpu, std::size_t cpu = 0){
+            Entry &e = entry(name, false);
+            if (e.resident){ gpuBytes -= e.gpuBytes; }
+            e.gpuBytes = gpu;  e.cpuBytes = cpu;  e.pinned = e.resident = true;  e.owned = false;  ++e.loads;
+            gpuBytes += gpu;  peakBytes = std::max(peakBytes, gpuBytes);
+        }
+        // drop a texture which is not needed anymore (e.g. the splash screen), even if pinned
+        void release(const std::string &name){
+            auto found = entries.find(name);
+            if (found == entries.end()  or  not found->second.resident){ return; }
+            Entry &e = found->second;
+            if (e.owned){ assets.unload(name); }
+            gpuBytes -= e.gpuBytes;
+            e.gpuBytes = e.cpuBytes = 0;  e.resident = e.pinned = false;
+        }
+
+        // call once per frame, before the get()'s of the frame
+        inline void nextFrame(){ ++frameNo; }
+        inline void setBudget(std::size_t budgetBytes){ budget = budgetBytes;  fitBudget(); }
+
+        inline std::size_t getBudget() const { return budget; }
+        inline std::size_t getGpuBytes() const { return gpuBytes; }
+        inline std::size_t getPeakBytes() const { return peakBytes; }
+        inline unsigned int getEvictions() const { return evictions; }
+
+        // every texture with its bytes, and whether it is resident right now
+        // (the main memory of a loaded one is its decoded pixels until they are uploaded)
+        void printReport() const {
+            std::printf("textures : %.1f MB on the GPU (peak %.1f MB, budget %.1f MB), %u evictions\n",
+                        gpuBytes / 1048576.0, peakBytes / 1048576.0, budget / 1048576.0, evictions);
+            for (const auto &each : entries){
+                const Entry &e = each.second;
+                std::size_t cpu = (e.owned)? assets.imageBytes(each.first) : e.cpuBytes;
+                std::printf("  %-40s %8.2f MB gpu %8.2f MB cpu  %-10s loads %u\n", each.first.c_str(),
+                            e.gpuBytes / 1048576.0, cpu / 1048576.0,
+                            (e.pinned)? "pinned" : (e.resident)? "resident" : "not loaded", e.loads);
+            }
+        }
+    };
+}
@@ -0,0 +1,186 @@
+
+#pragma once
+// a small fixed size pool of worker threads (decodes the assets, and splits the big collision and
+// update passes) : every worker has its own job deque, it takes its newest job first and when its
+// deque is empty it steals the oldest job of another worker, so nobody sits idle while work is left
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace Asteroid {
+
+    class ThreadPool {
+
+        private :
+
+        // a ring of jobs (a deque would allocate and free a block every few jobs), it only grows when full
+        struct JobQueue {
+            std::vector<std::function<void()>> ring;
+            std::size_t first = 0, count = 0;
+            std::mutex lock;
+
+            JobQueue() noexcept { ring.resize(64); }
+            void pushBack(std::function<void()> &&job){
+                if (count == ring.size()){ // unroll it into a twice as big ring
+                    std::vector<std::function<void()>> bigger(2 * ring.size());
+                    for (std::size_t k = 0; k < count; ++k){ bigger[k] = std::move(ring[(first + k) % ring.size()]); }
+                    ring.swap(bigger);  first = 0;
+                }
+                ring[(first + count++) % ring.size()] = std::move(job);
+            }
+            std::function<void()> popBack(){ --count;  return std::move(ring[(first + count) % ring.size()]); }
+            std::function<void()> popFront(){
+                std::function<void()> job = std::move(ring[first]);
+                first = (first + 1) % ring.size();  --count;
+                return job;
+            }
+        };
+
+        // the shared state of one parallelFor, kept by the pool (not on the caller's stack) : a helper job
+        // queued behind a long one (an image decode) may only run after parallelFor returned, it then finds
+        // no chunk left and just lets the slot go
+        struct ForSlot {
+            std::atomic<std::size_t> nextChunk{0}, doneChunks{0};
+            std::atomic<unsigned int> users{0};
+            std::size_t count = 0, grain = 0, chunks = 0;
+            void *body = nullptr;
+            void (*runRange)(void *, std::size_t, std::size_t) = nullptr;
+            /*
+            users    : the caller and its helper jobs not finished yet, the slot is free again at 0
+            body     : the caller's work (only called for a claimed chunk, so never after parallelFor returned)
+            */
+        };
+        static constexpr short int FOR_SLOTS = 8;
+
+        std::vector<std::unique_ptr<JobQueue>> queues;
+        std::vector<std::thread> workers;
+        std::array<ForSlot, FOR_SLOTS> forSlots;
+        std::atomic<unsigned int> queued, pending, nextQueue;
+        std::mutex sleepLock;
+        std::condition_variable wake, idle;
+        bool stopping;
+        /*
+        queues    : one per worker, submit() deals the jobs out round robin
+        queued    : jobs waiting in any deque,  pending : jobs waiting or running
+        wake      : signals the sleeping workers when a job arrives (or the pool stops)
+        idle      : signals waitIdle() when the last job is done
+        forSlots  : a few, for the helper jobs still queued from earlier parallelFor calls
+        */
+
+        static void runChunks(ForSlot &slot){
+            for (std::size_t c = slot.nextChunk++; c < slot.chunks; c = slot.nextChunk++){
+                slot.runRange(slot.body, c * slot.grain, std::min(slot.count, (c + 1) * slot.grain));
+                ++slot.doneChunks;
+            }
+        }
+
+        // own deque from the back, then the others from the front
+        bool take(unsigned int self, std::function<void()> &job){
+            for (unsigned int k = 0; k < queues.size(); ++k){
+                JobQueue &queue = *queues[(self + k) % queues.size()];
+                std::lock_guard<std::mutex> guard(queue.lock);
+                if (queue.count == 0){ continue; }
+                job = (k == 0)? queue.popBack() : queue.popFront();
+                --queued;
+                return true;
+            }
+            return false;
+        }
+
+        void work(unsigned int self){
+            while (true){
+                std::function<void()> job;
+                if (take(self, job)){
+                    job();
+                    if (--pending == 0){
+                        std::lock_guard<std::mutex> guard(sleepLock);
+                        idle.notify_all();
+                    }
+                    continue;
+                }
+                std::unique_lock<std::mutex> guard(sleepLock);
+                wake.wait(guard, [this]{ return stopping  or  queued > 0; });
+                if (stopping  and  queued == 0){ return; } // stopping and nothing left to do
+            }
+        }
+
+        public :
+
+        explicit ThreadPool(unsigned int threadCount = std::max(1U, std::thread::hardware_concurrency()))
+            : queued(0), pending(0), nextQueue(0) {
+            stopping = false;
+            for (unsigned int i = 0; i < threadCount; ++i){ queues.emplace_back(new JobQueue()); }
+            for (unsigned int i = 0; i < threadCount; ++i){ workers.emplace_back([this, i]{ work(i); }); }
+        }
+        ~ThreadPool(){
+            {
+                std::lock_guard<std::mutex> guard(sleepLock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread &worker : workers){ worker.join(); }
+        }
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool& operator=(const ThreadPool &) = delete;
+
+        void submit(std::function<void()> job){
+            JobQueue &queue = *queues[nextQueue++ % queues.size()];
+            ++pending;
+            {
+                std::lock_guard<std::mutex> guard(queue.lock);
+                queue.pushBack(std::move(job));
+            }
+            {
+                std::lock_guard<std::mutex> guard(sleepLock);
+                ++queued;
+            }
+            wake.notify_one();
+        }
+        // block until every submitted job is finished
+        void waitIdle(){
+            std::unique_lock<std::mutex> guard(sleepLock);
+            idle.wait(guard, [this]{ return pending == 0; });
+        }
+
+        // run work(from, to) over [0, count) in chunks of "grain" items, on the workers and on the
+        // calling thread too, returns when every chunk is done (must not be called from a worker)
+        // - the caller takes chunks as well, so when the workers are busy (decoding) it runs them all
+        //   itself and never waits for a queued helper, only for the chunks a helper already started
+        template<class Work> void parallelFor(std::size_t count, std::size_t grain, Work &&work){
+            using Body = std::remove_reference_t<Work>;
+            std::size_t chunks = (count + grain - 1) / grain;
+            if (chunks <= 1){ if (count > 0){ work(std::size_t(0), count); }  return; }
+
+            unsigned int helpers = std::min<std::size_t>(workers.size(), chunks - 1);
+            ForSlot *slot = nullptr;
+            for (ForSlot &each : forSlots){
+                unsigned int free = 0;
+                if (each.users.compare_exchange_strong(free, helpers + 1)){ slot = &each;  break; }
+            }
+            if (slot == nullptr){ // every slot waits for queued helpers : the same chunks, all on this thread
+                for (std::size_t c = 0; c < chunks; ++c){ work(c * grain, std::min(count, (c + 1) * grain)); }
+                return;
+            }
+            slot->count = count;  slot->grain = grain;  slot->chunks = chunks;
+            slot->nextChunk = 0;  slot->doneChunks = 0;
+            slot->body = const_cast<void *>(static_cast<const void *>(std::addressof(work)));
+            slot->runRange = [](void *body, std::size_t from, std::size_t to){ (*static_cast<Body *>(body))(from, to); };
+
+            for (unsigned int h = 0; h < helpers; ++h){ submit([slot](){ runChunks(*slot);  --slot->users; }); }
+            runChunks(*slot);
+            // every chunk is taken by now, the ones left are running on a helper (short : one chunk each)
+            while (slot->doneChunks < chunks){ std::this_thread::yield(); }
+            --slot->users;
+        }
+        inline unsigned int size() const { return workers.size(); }
+    };
+}